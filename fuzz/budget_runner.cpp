@@ -0,0 +1,154 @@
+#include "fuzz_common.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+// standalone runner: feeds files (or every file under directories) through the fuzz pipeline and fails if any
+// of them makes more allocations, allocates more bytes in total or needs more peak heap than the linear budget
+// allows; time is reported but not checked, so that results don't depend on the machine's load
+//   dot_parser_budget [--base-allocations N] [--allocations-per-unit N] [--base-total-bytes N]
+//                     [--total-bytes-per-unit N] [--base-bytes N] [--bytes-per-unit N] paths...
+
+// every allocation function is replaced, so that none bypasses the accounting
+// each block carries its size in front, in a header as large as the alignment asked for
+namespace {
+    dot_parser::fuzz::allocation_counter counter;
+
+    std::size_t header_size(std::size_t alignment) {
+        return std::max(alignment, alignof(std::max_align_t));
+    }
+    void* allocate(std::size_t size, std::size_t alignment=alignof(std::max_align_t)) noexcept {
+        auto header = header_size(alignment);
+        auto* block = static_cast<char*>(alignment<=alignof(std::max_align_t)
+                ? std::malloc(size+header)
+                : std::aligned_alloc(alignment, (size+header+alignment-1)/alignment*alignment));
+        if (block==nullptr) {
+            return nullptr;
+        }
+        *reinterpret_cast<std::size_t*>(block) = size;
+        counter.allocated(size);
+        return block+header;
+    }
+    void* allocate_or_throw(std::size_t size, std::size_t alignment=alignof(std::max_align_t)) {
+        if (void* p = allocate(size, alignment)) {
+            return p;
+        }
+        throw std::bad_alloc{};
+    }
+    void release(void* p, std::size_t alignment=alignof(std::max_align_t)) noexcept {
+        if (p==nullptr) {
+            return;
+        }
+        auto* block = static_cast<char*>(p)-header_size(alignment);
+        counter.freed(*reinterpret_cast<std::size_t*>(block));
+        std::free(block);
+    }
+    std::size_t to_size(std::align_val_t alignment) {
+        return static_cast<std::size_t>(alignment);
+    }
+}
+
+void* operator new(std::size_t size) { return allocate_or_throw(size); }
+void* operator new[](std::size_t size) { return allocate_or_throw(size); }
+void* operator new(std::size_t size, std::align_val_t al) { return allocate_or_throw(size, to_size(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return allocate_or_throw(size, to_size(al)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate(size, to_size(al)); }
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate(size, to_size(al)); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t al) noexcept { release(p, to_size(al)); }
+void operator delete[](void* p, std::align_val_t al) noexcept { release(p, to_size(al)); }
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept { release(p, to_size(al)); }
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept { release(p, to_size(al)); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept { release(p, to_size(al)); }
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept { release(p, to_size(al)); }
+
+namespace {
+    namespace fs = std::filesystem;
+    using namespace dot_parser::fuzz;
+
+    void collect(const fs::path& path, std::vector<fs::path>& files) {
+        if (fs::is_directory(path)) {
+            for (const auto& entry: fs::recursive_directory_iterator(path)) {
+                if (entry.is_regular_file()) {
+                    files.push_back(entry.path());
+                }
+            }
+        } else {
+            files.push_back(path);
+        }
+    }
+
+    // true if within budget
+    bool check(const fs::path& file, const budget& limits) {
+        std::ifstream in(file, std::ios::binary);
+        std::string input{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        auto result = run_pipeline(reinterpret_cast<const std::uint8_t*>(input.data()), input.size(), counter);
+        bool allocations_ok = within_allocations(limits, result);
+        bool memory_ok = within_memory(limits, result);
+        auto per_unit = std::max<std::size_t>(units(result), 1);
+        std::cout << file.string() << ": " << result.bytes << " bytes, " << result.edges << " edges, "
+                  << (result.accepted ? "accepted" : "rejected") << ", "
+                  << result.allocations << " allocations (" << result.allocations/per_unit << "/unit), "
+                  << result.total_bytes/1024 << " KiB allocated (" << result.total_bytes/per_unit << " B/unit), "
+                  << result.peak_bytes/1024 << " KiB peak (" << result.peak_bytes/per_unit << " B/unit), "
+                  << result.elapsed.count()/1000 << " us"
+                  << (allocations_ok ? "" : "  OVER ALLOCATION BUDGET") << (memory_ok ? "" : "  OVER MEMORY BUDGET") << '\n';
+        return allocations_ok && memory_ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    budget limits;
+    std::vector<fs::path> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::size_t {
+            if (i+1>=argc) {
+                std::cerr << "missing value for " << arg << '\n';
+                std::exit(2);
+            }
+            return std::stoull(argv[++i]);
+        };
+        if (arg=="--base-allocations") {
+            limits.base_allocations = value();
+        } else if (arg=="--allocations-per-unit") {
+            limits.allocations_per_unit = value();
+        } else if (arg=="--base-total-bytes") {
+            limits.base_total_bytes = value();
+        } else if (arg=="--total-bytes-per-unit") {
+            limits.total_bytes_per_unit = value();
+        } else if (arg=="--base-bytes") {
+            limits.base_bytes = value();
+        } else if (arg=="--bytes-per-unit") {
+            limits.bytes_per_unit = value();
+        } else {
+            collect(arg, files);
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "no inputs given\n";
+        return 2;
+    }
+    std::sort(files.begin(), files.end());
+    std::cerr.setstate(std::ios::failbit);  // flatten reports every discarded subgraph attribute set
+    std::size_t failed = 0;
+    for (const auto& file: files) {
+        failed += !check(file, limits);
+    }
+    std::cout << files.size()-failed << "/" << files.size() << " inputs within budget\n";
+    return failed==0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#ifndef DOT_PARSER_FUZZ_COMMON_HPP
+#define DOT_PARSER_FUZZ_COMMON_HPP
+
+#include "parser.hpp"
+#include "resolver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <string>
+
+// shared by the libFuzzer target and the standalone budget runner
+namespace dot_parser::fuzz {
+    // heap traffic of one run, fed by whatever sees the allocations: a replaced operator new or sanitizer hooks
+    struct allocation_counter {
+        bool active{};
+        std::size_t allocations{};
+        std::size_t total_bytes{};  // all bytes allocated, freed or not
+        std::size_t live_bytes{};
+        std::size_t peak_bytes{};
+
+        void allocated(std::size_t size) {
+            if (!active) {
+                return;
+            }
+            ++allocations;
+            total_bytes += size;
+            live_bytes += size;
+            peak_bytes = std::max(peak_bytes, live_bytes);
+        }
+        void freed(std::size_t size) {
+            if (active) {
+                live_bytes -= std::min(size, live_bytes);  // blocks from before the run don't count
+            }
+        }
+    };
+
+    struct run_result {
+        std::size_t bytes{};
+        std::size_t edges{};  // after expanding node groups and chains; 0 if parsing failed
+        std::chrono::nanoseconds elapsed{};
+        bool accepted{};  // parse, resolve and flatten all succeeded
+        std::size_t allocations{};
+        std::size_t total_bytes{};
+        std::size_t peak_bytes{};
+    };
+
+    // parse, resolve and flatten; rejected input is a normal outcome, only the cost matters
+    inline run_result run_pipeline(const std::uint8_t* data, std::size_t size, allocation_counter& counter) {
+        run_result result{ .bytes=size };
+        counter = allocation_counter{ .active=true };
+        auto start = std::chrono::steady_clock::now();
+        try {
+            auto raw_graph = parse(std::string(reinterpret_cast<const char*>(data), size));
+            result.edges = raw_graph.stats.edges;
+            auto flat_graph = flatten(resolve(raw_graph));
+            result.accepted = true;
+        } catch (const std::exception&) {
+        }
+        result.elapsed = std::chrono::steady_clock::now()-start;
+        counter.active = false;
+        result.allocations = counter.allocations;
+        result.total_bytes = counter.total_bytes;
+        result.peak_bytes = counter.peak_bytes;
+        return result;
+    }
+
+    // linear budget; every input byte and every expanded edge is one unit, since {a b} -> {c d} legitimately
+    // produces the product of both groups
+    struct budget {
+        // deterministic for a given standard library, so the budget runner checks these in CI
+        std::size_t base_allocations = std::size_t{1}<<16;
+        std::size_t allocations_per_unit = 32;
+        std::size_t base_total_bytes = std::size_t{16}<<20;  // catches quadratic copying that peak memory misses
+        std::size_t total_bytes_per_unit = 8192;
+        std::size_t base_bytes = std::size_t{4}<<20;
+        std::size_t bytes_per_unit = 2048;
+        // wall clock; checked by the fuzz target only, as it is too noisy on loaded machines
+        std::chrono::nanoseconds base_time = std::chrono::milliseconds(100);
+        std::chrono::nanoseconds time_per_unit = std::chrono::microseconds(5);
+    };
+    inline std::size_t units(const run_result& result) {
+        return result.bytes+result.edges;
+    }
+    inline bool within_allocations(const budget& limits, const run_result& result) {
+        return result.allocations <= limits.base_allocations+limits.allocations_per_unit*units(result)
+            && result.total_bytes <= limits.base_total_bytes+limits.total_bytes_per_unit*units(result);
+    }
+    inline bool within_memory(const budget& limits, const run_result& result) {
+        return result.peak_bytes <= limits.base_bytes+limits.bytes_per_unit*units(result);
+    }
+    inline bool within_time(const budget& limits, const run_result& result) {
+        return result.elapsed <= limits.base_time+limits.time_per_unit*static_cast<std::int64_t>(units(result));
+    }
+}
+
+#endif //DOT_PARSER_FUZZ_COMMON_HPP
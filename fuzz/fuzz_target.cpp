@@ -0,0 +1,46 @@
+#include "fuzz_common.hpp"
+#include <sanitizer/allocator_interface.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    dot_parser::fuzz::allocation_counter counter;
+
+    void on_malloc(const volatile void*, std::size_t size) {
+        counter.allocated(size);
+    }
+    void on_free(const volatile void* p) {
+        counter.freed(__sanitizer_get_allocated_size(p));
+    }
+
+    [[noreturn]] void over_budget(const char* what, const dot_parser::fuzz::run_result& result) {
+        std::fprintf(stderr, "over %s budget: %zu bytes, %zu edges, %lld ns, %zu allocations, %zu bytes allocated, %zu bytes peak\n",
+                     what, result.bytes, result.edges, static_cast<long long>(result.elapsed.count()),
+                     result.allocations, result.total_bytes, result.peak_bytes);
+        std::abort();
+    }
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    std::cerr.setstate(std::ios::failbit);  // flatten reports every discarded subgraph attribute set
+    __sanitizer_install_malloc_and_free_hooks(on_malloc, on_free);
+    return 0;
+}
+
+// inputs over budget abort, so that libFuzzer keeps and can minimize them (-minimize_crash=1)
+// allocation and memory counts are deterministic and dot_parser_budget checks the same limits; time is not
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    static const dot_parser::fuzz::budget limits{};
+    auto result = dot_parser::fuzz::run_pipeline(data, size, counter);
+    if (!dot_parser::fuzz::within_allocations(limits, result)) {
+        over_budget("allocation", result);
+    }
+    if (!dot_parser::fuzz::within_memory(limits, result)) {
+        over_budget("memory", result);
+    }
+    if (!dot_parser::fuzz::within_time(limits, result)) {
+        over_budget("time", result);
+    }
+    return 0;
+}
@@ -0,0 +1,372 @@
+#include "analytics.hpp"
+#include "detail/flat_hash_map.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace dot_parser {
+    namespace detail {
+        // work below this many items per thread stays on the calling thread
+        constexpr std::size_t min_chunk = 1<<12;
+
+        std::size_t chunk_count(std::size_t items, std::size_t threads) {
+            if (threads==0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            return std::max<std::size_t>(1, std::min(threads, items/min_chunk));
+        }
+
+        // calls fn(chunk, begin, end) for chunks contiguous slices of [0, items), the first one on this thread
+        template<typename Fn>
+        void parallel_for(std::size_t items, std::size_t chunks, const Fn& fn) {
+            if (chunks==1) {
+                fn(0, 0, items);
+                return;
+            }
+            std::vector<std::exception_ptr> errors(chunks);
+            auto run = [&](std::size_t chunk) {
+                try {
+                    fn(chunk, chunk*items/chunks, (chunk+1)*items/chunks);
+                } catch (...) {
+                    errors[chunk] = std::current_exception();
+                }
+            };
+            {
+                std::vector<std::thread> pool;
+                struct join_all {  // threads already started are joined on every way out of this block
+                    std::vector<std::thread>& threads;
+                    ~join_all() {
+                        for (auto& t: threads) {
+                            t.join();
+                        }
+                    }
+                } joiner{pool};
+                pool.reserve(chunks-1);
+                for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+                    try {
+                        pool.emplace_back(run, chunk);
+                    } catch (const std::system_error&) {  // out of threads: this thread takes the chunk
+                        run(chunk);
+                    }
+                }
+                run(0);
+            }
+            for (auto& error: errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+        // exclusive prefix sum in place: counts become offsets
+        void prefix_sum(std::vector<std::size_t>& counts) {
+            std::size_t sum = 0;
+            for (auto& c: counts) {
+                auto here = c;
+                c = sum;
+                sum += here;
+            }
+        }
+
+        // concurrent union-find; roots always point to smaller ids, so every root is its component's minimum
+        struct union_find {
+            std::vector<std::atomic<vertex_id>> parent;
+
+            explicit union_find(std::size_t n): parent(n) {
+                for (std::size_t v = 0; v < n; ++v) {
+                    parent[v].store(static_cast<vertex_id>(v), std::memory_order_relaxed);
+                }
+            }
+            vertex_id find(vertex_id v) {
+                auto p = parent[v].load(std::memory_order_acquire);
+                while (p!=v) {
+                    auto gp = parent[p].load(std::memory_order_acquire);
+                    parent[v].compare_exchange_weak(p, gp, std::memory_order_acq_rel);  // path halving; losing the race is fine
+                    v = p;
+                    p = parent[v].load(std::memory_order_acquire);
+                }
+                return v;
+            }
+            void unite(vertex_id a, vertex_id b) {
+                while (true) {
+                    a = find(a);
+                    b = find(b);
+                    if (a==b) {
+                        return;
+                    }
+                    if (a<b) {
+                        std::swap(a, b);
+                    }
+                    auto expected = a;  // a is still a root unless another thread hooked it meanwhile
+                    if (parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) {
+                        return;
+                    }
+                }
+            }
+        };
+    }
+
+    graph_adjacency make_adjacency(const dot_graph_flat& graph, std::size_t threads) {
+        graph_adjacency adj{ .directed=graph.graph_type=="digraph" };
+        // ids for all nodes first, and where each statement's edges go in the edge array
+        auto node_stmts = static_cast<std::size_t>(std::count_if(graph.statements.begin(), graph.statements.end(),
+                [](const flat_stmt_type& stmt) { return std::holds_alternative<detail::node_stmt_v>(stmt); }));
+        detail::flat_hash_map<std::string_view, vertex_id> ids(node_stmts);
+        adj.names.reserve(node_stmts);
+        std::vector<std::size_t> edge_starts(graph.statements.size()+1, 0);
+        for (std::size_t i = 0; i < graph.statements.size(); ++i) {
+            const auto& stmt = graph.statements[i];
+            if (std::holds_alternative<detail::node_stmt_v>(stmt)) {
+                const auto& name = std::get<detail::node_stmt_v>(stmt).node_name;
+                if (ids.try_emplace(name, static_cast<vertex_id>(adj.names.size())).second) {
+                    adj.names.emplace_back(name);
+                }
+                edge_starts[i] = 0;
+            } else {
+                edge_starts[i] = std::get<detail::edge_stmt_v>(stmt).edges.size();
+            }
+        }
+        if (adj.names.size()>=no_vertex) {
+            throw std::runtime_error("too many nodes for 32-bit vertex ids");
+        }
+        detail::prefix_sum(edge_starts);
+        adj.edge_count = edge_starts.back();
+
+        // name lookups are the expensive part; done in parallel over statements
+        std::vector<std::pair<vertex_id, vertex_id>> ends(adj.edge_count);
+        detail::parallel_for(graph.statements.size(), detail::chunk_count(graph.statements.size(), threads),
+                             [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                if (!std::holds_alternative<detail::edge_stmt_v>(graph.statements[i])) {
+                    continue;
+                }
+                auto at = edge_starts[i];
+                for (const auto& e: std::get<detail::edge_stmt_v>(graph.statements[i]).edges) {
+                    const auto* src = ids.find(e.src);
+                    const auto* tgt = ids.find(e.tgt);
+                    if (src==nullptr || tgt==nullptr) {
+                        throw std::runtime_error("edge " + e.to_string() + " contains undefined node(s)");
+                    }
+                    ends[at++] = {*src, *tgt};
+                }
+            }
+        });
+
+        auto n = adj.vertex_count();
+        adj.out_offsets.assign(n+1, 0);
+        if (adj.directed) {
+            adj.in_offsets.assign(n+1, 0);
+        }
+        for (auto [src, tgt]: ends) {
+            ++adj.out_offsets[src];
+            ++(adj.directed ? adj.in_offsets : adj.out_offsets)[tgt];
+        }
+        detail::prefix_sum(adj.out_offsets);
+        adj.out_targets.resize(adj.out_offsets.back());
+        std::vector<std::size_t> out_next(adj.out_offsets.begin(), adj.out_offsets.end()-1);
+        if (adj.directed) {
+            detail::prefix_sum(adj.in_offsets);
+            adj.in_sources.resize(adj.in_offsets.back());
+            std::vector<std::size_t> in_next(adj.in_offsets.begin(), adj.in_offsets.end()-1);
+            for (auto [src, tgt]: ends) {
+                adj.out_targets[out_next[src]++] = tgt;
+                adj.in_sources[in_next[tgt]++] = src;
+            }
+        } else {
+            for (auto [src, tgt]: ends) {
+                adj.out_targets[out_next[src]++] = tgt;
+                adj.out_targets[out_next[tgt]++] = src;
+            }
+        }
+        return adj;
+    }
+
+    std::vector<vertex_id> connected_components(const graph_adjacency& graph, std::size_t threads) {
+        auto n = graph.vertex_count();
+        detail::union_find components(n);
+        auto chunks = detail::chunk_count(n, threads);
+        detail::parallel_for(n, chunks, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (auto v = static_cast<vertex_id>(begin); v < end; ++v) {
+                for (auto u: graph.out(v)) {
+                    components.unite(v, u);
+                }
+            }
+        });
+        std::vector<vertex_id> labels(n);
+        detail::parallel_for(n, chunks, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (auto v = static_cast<vertex_id>(begin); v < end; ++v) {
+                labels[v] = components.find(v);
+            }
+        });
+        return labels;
+    }
+
+    std::vector<vertex_id> strongly_connected_components(const graph_adjacency& graph) {
+        auto n = graph.vertex_count();
+        std::vector<vertex_id> components(n, no_vertex);
+        std::vector<vertex_id> order(n, no_vertex);  // discovery index
+        std::vector<vertex_id> low(n);
+        std::vector<vertex_id> tarjan_stack;
+        // (vertex, index of next neighbor); explicit stack in place of recursion
+        std::vector<std::pair<vertex_id, std::size_t>> call_stack;
+        vertex_id discovered = 0;
+        vertex_id found = 0;
+        for (vertex_id root = 0; root < n; ++root) {
+            if (order[root]!=no_vertex) {
+                continue;
+            }
+            order[root] = low[root] = discovered++;
+            tarjan_stack.push_back(root);
+            call_stack.emplace_back(root, 0);
+            while (!call_stack.empty()) {
+                auto& [v, next] = call_stack.back();
+                auto neighbors = graph.out(v);
+                if (next<neighbors.size()) {
+                    auto u = neighbors.first[next++];
+                    if (order[u]==no_vertex) {
+                        order[u] = low[u] = discovered++;
+                        tarjan_stack.push_back(u);
+                        call_stack.emplace_back(u, 0);  // invalidates v and next
+                    } else if (components[u]==no_vertex) {  // still on the stack
+                        low[v] = std::min(low[v], order[u]);
+                    }
+                    continue;
+                }
+                auto done = v;
+                call_stack.pop_back();
+                if (!call_stack.empty()) {
+                    auto parent = call_stack.back().first;
+                    low[parent] = std::min(low[parent], low[done]);
+                }
+                if (low[done]==order[done]) {
+                    vertex_id w;
+                    do {
+                        w = tarjan_stack.back();
+                        tarjan_stack.pop_back();
+                        components[w] = found;
+                    } while (w!=done);
+                    ++found;
+                }
+            }
+        }
+        return components;
+    }
+
+    std::optional<std::vector<vertex_id>> topological_order(const graph_adjacency& graph) {
+        if (!graph.directed) {
+            throw std::runtime_error("topological order of an undirected graph");
+        }
+        auto n = graph.vertex_count();
+        std::vector<std::size_t> pending(n);
+        std::vector<vertex_id> order;
+        order.reserve(n);
+        for (vertex_id v = 0; v < n; ++v) {
+            pending[v] = graph.in(v).size();
+            if (pending[v]==0) {
+                order.push_back(v);
+            }
+        }
+        // order doubles as the queue
+        for (std::size_t head = 0; head < order.size(); ++head) {
+            for (auto u: graph.out(order[head])) {
+                if (--pending[u]==0) {
+                    order.push_back(u);
+                }
+            }
+        }
+        if (order.size()<n) {
+            return std::nullopt;
+        }
+        return order;
+    }
+
+    bool has_cycle(const graph_adjacency& graph) {
+        if (graph.directed) {
+            return !topological_order(graph).has_value();
+        }
+        // a forest has exactly vertex_count - components edges
+        auto labels = connected_components(graph);
+        std::size_t roots = 0;
+        for (vertex_id v = 0; v < labels.size(); ++v) {
+            roots += labels[v]==v;
+        }
+        return graph.edge_count>graph.vertex_count()-roots;
+    }
+
+    degree_distribution degrees(const graph_adjacency& graph, std::size_t threads) {
+        auto n = graph.vertex_count();
+        auto chunks = detail::chunk_count(n, threads);
+        std::vector<degree_distribution> partial(chunks);
+        auto count = [](std::vector<std::size_t>& histogram, std::size_t degree) {
+            if (degree>=histogram.size()) {
+                histogram.resize(degree+1, 0);
+            }
+            ++histogram[degree];
+        };
+        detail::parallel_for(n, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto& mine = partial[chunk];
+            for (auto v = static_cast<vertex_id>(begin); v < end; ++v) {
+                count(mine.out, graph.out(v).size());
+                if (graph.directed) {
+                    count(mine.in, graph.in(v).size());
+                }
+            }
+        });
+        degree_distribution result;
+        auto merge = [](std::vector<std::size_t>& into, const std::vector<std::size_t>& from) {
+            if (from.size()>into.size()) {
+                into.resize(from.size(), 0);
+            }
+            for (std::size_t d = 0; d < from.size(); ++d) {
+                into[d] += from[d];
+            }
+        };
+        for (const auto& p: partial) {
+            merge(result.out, p.out);
+            merge(result.in, p.in);
+        }
+        return result;
+    }
+
+    std::vector<vertex_id> bfs_distances(const graph_adjacency& graph, vertex_id source, std::size_t threads) {
+        auto n = graph.vertex_count();
+        if (source>=n) {
+            throw std::runtime_error("bfs source " + std::to_string(source) + " out of range");
+        }
+        std::vector<std::atomic<vertex_id>> distances(n);
+        for (auto& d: distances) {
+            d.store(no_vertex, std::memory_order_relaxed);
+        }
+        distances[source].store(0, std::memory_order_relaxed);
+        // level-synchronous; each thread claims unvisited vertices with a CAS and collects them for the next level
+        std::vector<vertex_id> frontier{source};
+        for (vertex_id level = 1; !frontier.empty(); ++level) {
+            auto chunks = detail::chunk_count(frontier.size(), threads);
+            std::vector<std::vector<vertex_id>> next(chunks);
+            detail::parallel_for(frontier.size(), chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                auto& mine = next[chunk];
+                for (auto i = begin; i < end; ++i) {
+                    for (auto u: graph.out(frontier[i])) {
+                        auto expected = no_vertex;
+                        if (distances[u].load(std::memory_order_relaxed)==no_vertex
+                                && distances[u].compare_exchange_strong(expected, level, std::memory_order_relaxed)) {
+                            mine.push_back(u);
+                        }
+                    }
+                }
+            });
+            frontier.clear();
+            for (const auto& part: next) {
+                frontier.insert(frontier.end(), part.begin(), part.end());
+            }
+        }
+        std::vector<vertex_id> result(n);
+        for (std::size_t v = 0; v < n; ++v) {
+            result[v] = distances[v].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+}
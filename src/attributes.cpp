@@ -0,0 +1,317 @@
+#include "attributes.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <utility>
+
+namespace dot_parser {
+    namespace detail {
+        struct known_attr {
+            std::string_view name;
+            attr_kind kind;
+        };
+        constexpr std::array<known_attr, 38> known_attrs {{
+            {"weight", attr_kind::number}, {"width", attr_kind::number}, {"height", attr_kind::number},
+            {"penwidth", attr_kind::number}, {"fontsize", attr_kind::number}, {"arrowsize", attr_kind::number},
+            {"len", attr_kind::number}, {"minlen", attr_kind::number}, {"nodesep", attr_kind::number},
+            {"ranksep", attr_kind::number}, {"peripheries", attr_kind::number}, {"sides", attr_kind::number},
+            {"skew", attr_kind::number}, {"distortion", attr_kind::number}, {"orientation", attr_kind::number},
+            {"pos", attr_kind::point}, {"lp", attr_kind::point}, {"xlp", attr_kind::point}, {"size", attr_kind::point},
+            {"color", attr_kind::color}, {"fillcolor", attr_kind::color}, {"fontcolor", attr_kind::color},
+            {"bgcolor", attr_kind::color}, {"pencolor", attr_kind::color}, {"labelfontcolor", attr_kind::color},
+            {"constraint", attr_kind::boolean}, {"fixedsize", attr_kind::boolean}, {"regular", attr_kind::boolean},
+            {"center", attr_kind::boolean}, {"compound", attr_kind::boolean}, {"concentrate", attr_kind::boolean},
+            {"decorate", attr_kind::boolean}, {"headclip", attr_kind::boolean}, {"tailclip", attr_kind::boolean},
+            {"newrank", attr_kind::boolean},
+            {"dir", attr_kind::enumeration}, {"rankdir", attr_kind::enumeration}, {"rank", attr_kind::enumeration}
+        }};
+        // allowed values of the enumeration attributes above
+        constexpr std::array<std::pair<std::string_view, std::string_view>, 3> enum_values {{
+            {"dir", " forward back both none "},
+            {"rankdir", " TB LR BT RL "},
+            {"rank", " same min source max sink "}
+        }};
+
+        std::string_view trim(std::string_view s) {
+            auto is_blank = [](char c) { return c==' ' || c=='\t'; };
+            while (!s.empty() && is_blank(s.front())) { s.remove_prefix(1); }
+            while (!s.empty() && is_blank(s.back())) { s.remove_suffix(1); }
+            return s;
+        }
+
+        bool iequals(std::string_view a, std::string_view b) {
+            return a.size()==b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                return std::tolower(static_cast<unsigned char>(x))==std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+
+        std::optional<int> parse_hex_byte(std::string_view s) {
+            int v{};
+            auto [ptr, ec] = std::from_chars(s.data(), s.data()+s.size(), v, 16);
+            if (ec!=std::errc{} || ptr!=s.data()+s.size()) {
+                return std::nullopt;
+            }
+            return v;
+        }
+
+        color from_hsv(double h, double s, double v) {  // all in [0, 1]
+            auto to_byte = [](double x) { return static_cast<std::uint8_t>(std::lround(std::clamp(x, 0.0, 1.0)*255)); };
+            double hh = std::fmod(h, 1.0)*6;
+            auto sector = static_cast<int>(hh);
+            double f = hh-sector;
+            double p = v*(1-s), q = v*(1-s*f), t = v*(1-s*(1-f));
+            switch (sector) {
+                case 0: return color{to_byte(v), to_byte(t), to_byte(p)};
+                case 1: return color{to_byte(q), to_byte(v), to_byte(p)};
+                case 2: return color{to_byte(p), to_byte(v), to_byte(t)};
+                case 3: return color{to_byte(p), to_byte(q), to_byte(v)};
+                case 4: return color{to_byte(t), to_byte(p), to_byte(v)};
+                default: return color{to_byte(v), to_byte(p), to_byte(q)};
+            }
+        }
+    }
+
+    attr_kind kind_of(std::string_view key) {
+        for (const auto& known: detail::known_attrs) {
+            if (known.name==key) {
+                return known.kind;
+            }
+        }
+        return attr_kind::string;
+    }
+
+    std::optional<double> parse_number(std::string_view s) {
+        s = detail::trim(s);
+        if (!s.empty() && s.front()=='+') {  // from_chars doesn't take a leading plus
+            s.remove_prefix(1);
+        }
+        double v{};
+        auto [ptr, ec] = std::from_chars(s.data(), s.data()+s.size(), v);
+        if (s.empty() || ec!=std::errc{} || ptr!=s.data()+s.size()) {
+            return std::nullopt;
+        }
+        return v;
+    }
+
+    std::optional<point> parse_point(std::string_view s) {
+        s = detail::trim(s);
+        point p;
+        if (!s.empty() && s.back()=='!') {
+            p.pinned = true;
+            s.remove_suffix(1);
+        }
+        auto comma = s.find(',');
+        if (comma==std::string_view::npos) {
+            return std::nullopt;
+        }
+        auto x = parse_number(s.substr(0, comma));
+        auto y = parse_number(s.substr(comma+1));
+        if (!x || !y) {
+            return std::nullopt;
+        }
+        p.x = *x;
+        p.y = *y;
+        return p;
+    }
+
+    std::optional<color> parse_color(std::string_view s) {
+        s = detail::trim(s);
+        if (!s.empty() && s.front()=='#') {
+            if (s.size()!=7 && s.size()!=9) {
+                return std::nullopt;
+            }
+            std::array<std::uint8_t, 4> rgba {0, 0, 0, 255};
+            for (std::size_t i = 0; 1+2*i < s.size(); ++i) {
+                auto byte = detail::parse_hex_byte(s.substr(1+2*i, 2));
+                if (!byte) {
+                    return std::nullopt;
+                }
+                rgba[i] = static_cast<std::uint8_t>(*byte);
+            }
+            return color{rgba[0], rgba[1], rgba[2], rgba[3]};
+        }
+        // "h,s,v" or "h s v"
+        auto sep = s.find_first_of(", ");
+        if (sep!=std::string_view::npos) {
+            auto sep_2 = s.find_first_of(", ", sep+1);
+            if (sep_2==std::string_view::npos) {
+                return std::nullopt;
+            }
+            auto h = parse_number(s.substr(0, sep));
+            auto sat = parse_number(s.substr(sep+1, sep_2-sep-1));
+            auto v = parse_number(s.substr(sep_2+1));
+            if (!h || !sat || !v) {
+                return std::nullopt;
+            }
+            return detail::from_hsv(*h, *sat, *v);
+        }
+        constexpr std::array<std::pair<std::string_view, color>, 10> names {{
+            {"black", {0, 0, 0}}, {"white", {255, 255, 255}}, {"red", {255, 0, 0}},
+            {"green", {0, 255, 0}}, {"blue", {0, 0, 255}}, {"yellow", {255, 255, 0}},
+            {"gray", {192, 192, 192}}, {"grey", {192, 192, 192}},
+            {"none", {0, 0, 0, 0}}, {"transparent", {255, 255, 254, 0}}
+        }};
+        for (const auto& [name, c]: names) {
+            if (detail::iequals(name, s)) {
+                return c;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<bool> parse_bool(std::string_view s) {
+        s = detail::trim(s);
+        if (detail::iequals(s, "true") || detail::iequals(s, "yes")) {
+            return true;
+        }
+        if (detail::iequals(s, "false") || detail::iequals(s, "no")) {
+            return false;
+        }
+        int v{};
+        auto [ptr, ec] = std::from_chars(s.data(), s.data()+s.size(), v);
+        if (s.empty() || ec!=std::errc{} || ptr!=s.data()+s.size()) {
+            return std::nullopt;
+        }
+        return v!=0;
+    }
+
+    attr_value decode(std::string_view key, std::string_view s) {
+        auto or_missing = [](auto opt) -> attr_value {
+            if (opt) {
+                return *opt;
+            }
+            return std::monostate{};
+        };
+        switch (kind_of(key)) {
+            case attr_kind::number: return or_missing(parse_number(s));
+            case attr_kind::point: return or_missing(parse_point(s));
+            case attr_kind::color: return or_missing(parse_color(s));
+            case attr_kind::boolean: return or_missing(parse_bool(s));
+            case attr_kind::enumeration: {
+                auto allowed = std::find_if(detail::enum_values.begin(), detail::enum_values.end(),
+                                            [&key](const auto& p) { return p.first==key; })->second;
+                auto trimmed = detail::trim(s);
+                if (trimmed.empty() || trimmed.find(' ')!=std::string_view::npos
+                    || allowed.find(" " + std::string{trimmed} + " ")==std::string_view::npos) {
+                    return std::monostate{};
+                }
+                return std::string{trimmed};
+            }
+            case attr_kind::string: break;
+        }
+        return std::string{s};
+    }
+
+    const attr_value& typed_attrs::entry::get(const std::string& key) {
+        static const attr_value missing;
+        auto it = std::find_if(attrs->begin(), attrs->end(), [&key](const auto& item) { return item.first==key; });
+        if (it==attrs->end()) {
+            return missing;
+        }
+        if (cache.empty()) {
+            cache.resize(attrs->size());
+        }
+        auto& slot = cache[it-attrs->begin()];
+        if (!slot) {
+            slot = decode(it->first, it->second);
+        }
+        return *slot;
+    }
+
+    void typed_attrs::add(const detail::node_stmt_v& v) {
+        node_ids.emplace(v.node_name, nodes.size());
+        nodes.push_back(node_entry{ {&v.attrs, {}}, &v });
+    }
+
+    void typed_attrs::add(const detail::edge_stmt_v& v) {
+        for (const auto& e: v.edges) {
+            edges.emplace_back(&e, edge_stmts.size());
+        }
+        edge_stmts.push_back(entry{&v.attrs, {}});
+    }
+
+    typed_attrs::typed_attrs(const dot_graph_flat& graph) {
+        for (const auto& stmt: graph.statements) {
+            std::visit([this](const auto& v) { add(v); }, stmt);
+        }
+    }
+
+    typed_attrs::typed_attrs(const dot_graph_resolved& graph) {
+        // same traversal as flatten
+        std::vector<std::pair<const dot_graph_resolved*, std::size_t>> stack;
+        stack.emplace_back(&graph, 0);
+        while (!stack.empty()) {
+            auto& [g, next] = stack.back();
+            if (next==g->statements.size()) {
+                stack.pop_back();
+                continue;
+            }
+            const auto& stmt = g->statements[next++];
+            if (std::holds_alternative<detail::node_stmt_v>(stmt)) {
+                add(std::get<detail::node_stmt_v>(stmt));
+            } else if (std::holds_alternative<detail::edge_stmt_v>(stmt)) {
+                add(std::get<detail::edge_stmt_v>(stmt));
+            } else {
+                assert(std::holds_alternative<dot_graph_resolved>(stmt));
+                stack.emplace_back(&std::get<dot_graph_resolved>(stmt), 0);
+            }
+        }
+    }
+
+    std::optional<std::size_t> typed_attrs::node_id(const std::string& name) const {
+        auto it = node_ids.find(name);
+        if (it==node_ids.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    const attr_value& typed_attrs::node_attr(std::size_t node, const std::string& key) {
+        return nodes[node].get(key);
+    }
+
+    const attr_value& typed_attrs::edge_attr(std::size_t e, const std::string& key) {
+        return edge_stmts[edges[e].second].get(key);
+    }
+
+    std::optional<double> typed_attrs::node_number(std::size_t node, const std::string& key) {
+        const auto& v = node_attr(node, key);
+        if (std::holds_alternative<double>(v)) {
+            return std::get<double>(v);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<double> typed_attrs::edge_number(std::size_t e, const std::string& key) {
+        const auto& v = edge_attr(e, key);
+        if (std::holds_alternative<double>(v)) {
+            return std::get<double>(v);
+        }
+        return std::nullopt;
+    }
+
+    std::vector<double> typed_attrs::node_numbers(const std::string& key, double fallback) {
+        std::vector<double> result(nodes.size(), fallback);
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            result[i] = node_number(i, key).value_or(fallback);
+        }
+        return result;
+    }
+
+    std::vector<double> typed_attrs::edge_numbers(const std::string& key, double fallback) {
+        std::vector<double> result(edges.size(), fallback);
+        std::size_t decoded_stmt = edge_stmts.size();  // edges of one statement share the value
+        double value = fallback;
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            if (edges[i].second!=decoded_stmt) {
+                decoded_stmt = edges[i].second;
+                value = edge_number(i, key).value_or(fallback);
+            }
+            result[i] = value;
+        }
+        return result;
+    }
+}
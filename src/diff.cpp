@@ -0,0 +1,225 @@
+#include "diff.hpp"
+#include <cassert>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace dot_parser {
+    namespace detail {
+        struct fnv_hasher {  // 64-bit FNV-1a; unlike std::hash, stable across runs and platforms
+            std::uint64_t state = 14695981039346656037ull;
+            void add(std::string_view s) {
+                for (auto c: s) {
+                    state ^= static_cast<unsigned char>(c);
+                    state *= 1099511628211ull;
+                }
+                add(static_cast<std::uint64_t>(s.size()));  // delimit adjacent strings
+            }
+            void add(std::uint64_t v) {
+                for (int i = 0; i < 8; ++i) {
+                    state ^= (v >> (8*i)) & 0xff;
+                    state *= 1099511628211ull;
+                }
+            }
+        };
+
+        template<typename Attrs>
+        void hash_attrs(fnv_hasher& h, const Attrs& attrs) {
+            h.add(static_cast<std::uint64_t>(attrs.size()));
+            for (const auto& [key, value]: attrs) {
+                h.add(key);
+                h.add(value);
+            }
+        }
+
+        void hash_edge(fnv_hasher& h, const edge& e) {
+            // undirected edges compare equal both ways round, so should their hashes
+            bool swap = e.edge_op=="--" && e.tgt<e.src;
+            h.add(swap ? e.tgt : e.src);
+            h.add(e.edge_op);
+            h.add(swap ? e.src : e.tgt);
+        }
+
+        using attrs_by_node = std::unordered_map<std::string, const attr_list_type*>;
+        using attrs_by_edge = std::unordered_map<edge, std::pair<std::vector<const attr_list_type*>, std::size_t>>;  // (attrs of each copy, copies matched)
+
+        void diff_nodes(const dot_graph_resolved& before, const dot_graph_resolved& after, graph_diff& result) {
+            attrs_by_node after_nodes;
+            for (const auto& stmt: after.statements) {
+                if (const auto* v = std::get_if<node_stmt_v>(&stmt)) {
+                    after_nodes.emplace(v->node_name, &v->attrs);
+                }
+            }
+            for (const auto& stmt: before.statements) {
+                if (const auto* v = std::get_if<node_stmt_v>(&stmt)) {
+                    auto it = after_nodes.find(v->node_name);
+                    if (it==after_nodes.end()) {
+                        result.removed_nodes.push_back(v->node_name);
+                        continue;
+                    }
+                    if (*it->second!=v->attrs) {
+                        result.changed_nodes.push_back(v->node_name);
+                    }
+                    after_nodes.erase(it);
+                }
+            }
+            for (const auto& stmt: after.statements) {  // whatever is left is new; keep declaration order
+                if (const auto* v = std::get_if<node_stmt_v>(&stmt)) {
+                    if (after_nodes.contains(v->node_name)) {
+                        result.added_nodes.push_back(v->node_name);
+                    }
+                }
+            }
+        }
+
+        void diff_edges(const dot_graph_resolved& before, const dot_graph_resolved& after, graph_diff& result) {
+            // multi-edges are paired up in declaration order
+            attrs_by_edge after_edges;
+            for (const auto& stmt: after.statements) {
+                if (const auto* v = std::get_if<edge_stmt_v>(&stmt)) {
+                    for (const auto& e: v->edges) {
+                        after_edges[e].first.push_back(&v->attrs);
+                    }
+                }
+            }
+            for (const auto& stmt: before.statements) {
+                if (const auto* v = std::get_if<edge_stmt_v>(&stmt)) {
+                    for (const auto& e: v->edges) {
+                        auto it = after_edges.find(e);
+                        if (it==after_edges.end() || it->second.second==it->second.first.size()) {
+                            result.removed_edges.push_back(e);
+                            continue;
+                        }
+                        auto& [copies, matched] = it->second;
+                        if (*copies[matched++]!=v->attrs) {
+                            result.changed_edges.push_back(e);
+                        }
+                    }
+                }
+            }
+            std::unordered_map<edge, std::size_t> seen;
+            for (const auto& stmt: after.statements) {
+                if (const auto* v = std::get_if<edge_stmt_v>(&stmt)) {
+                    for (const auto& e: v->edges) {
+                        if (seen[e]++>=after_edges[e].second) {
+                            result.added_edges.push_back(e);
+                        }
+                    }
+                }
+            }
+        }
+
+        // direct subgraphs keyed by (name, occurrence of that name), so that unnamed subgraphs pair up by position
+        std::vector<std::pair<std::pair<std::string, std::size_t>, const dot_graph_resolved*>> keyed_subgraphs(const dot_graph_resolved& graph) {
+            std::vector<std::pair<std::pair<std::string, std::size_t>, const dot_graph_resolved*>> result;
+            std::unordered_map<std::string, std::size_t> occurrences;
+            for (const auto& stmt: graph.statements) {
+                if (const auto* sub = std::get_if<dot_graph_resolved>(&stmt)) {
+                    result.emplace_back(std::make_pair(sub->name, occurrences[sub->name]++), sub);
+                }
+            }
+            return result;
+        }
+    }
+
+    bool graph_diff::empty() const {
+        return added_nodes.empty() && removed_nodes.empty() && changed_nodes.empty()
+            && added_edges.empty() && removed_edges.empty() && changed_edges.empty()
+            && added_subgraphs.empty() && removed_subgraphs.empty() && changed_subgraphs.empty();
+    }
+
+    std::uint64_t structural_hash(const dot_graph_resolved& graph) {
+        detail::fnv_hasher h;
+        h.add(graph.name);
+        detail::hash_attrs(h, graph.graph_attrs);
+        for (const auto& stmt: graph.statements) {
+            h.add(static_cast<std::uint64_t>(stmt.index()));
+            if (std::holds_alternative<detail::node_stmt_v>(stmt)) {
+                const auto& v = std::get<detail::node_stmt_v>(stmt);
+                h.add(v.node_name);
+                detail::hash_attrs(h, v.attrs);
+            } else if (std::holds_alternative<detail::edge_stmt_v>(stmt)) {
+                const auto& v = std::get<detail::edge_stmt_v>(stmt);
+                h.add(static_cast<std::uint64_t>(v.edges.size()));
+                for (const auto& e: v.edges) {
+                    detail::hash_edge(h, e);
+                }
+                detail::hash_attrs(h, v.attrs);
+            } else {
+                assert(std::holds_alternative<dot_graph_resolved>(stmt));
+                h.add(std::get<dot_graph_resolved>(stmt).hash);
+            }
+        }
+        return h.state;
+    }
+
+    void compute_hashes(dot_graph_resolved& graph) {
+        // post-order with an explicit stack: a graph is hashed once all of its subgraphs are
+        std::vector<std::pair<dot_graph_resolved*, std::size_t>> stack;
+        stack.emplace_back(&graph, 0);
+        while (!stack.empty()) {
+            auto& [g, next] = stack.back();
+            if (next==g->statements.size()) {
+                g->hash = structural_hash(*g);
+                stack.pop_back();
+                continue;
+            }
+            auto* sub = std::get_if<dot_graph_resolved>(&g->statements[next++]);
+            if (sub!=nullptr) {
+                stack.emplace_back(sub, 0);  // invalidates g and next
+            }
+        }
+    }
+
+    graph_diff diff(const dot_graph_resolved& before, const dot_graph_resolved& after) {
+        if (before.hash==0 || after.hash==0) {
+            throw std::runtime_error("diff requires structural hashes; resolve with compute_hashes set");
+        }
+        graph_diff result;
+        struct pending {
+            const dot_graph_resolved* before;
+            const dot_graph_resolved* after;
+            subgraph_path path;
+        };
+        std::vector<pending> stack;
+        stack.push_back(pending{&before, &after, {}});
+        while (!stack.empty()) {
+            auto [old_graph, new_graph, path] = std::move(stack.back());
+            stack.pop_back();
+            if (old_graph->hash==new_graph->hash) {  // identical subtree
+                continue;
+            }
+            if (old_graph->graph_attrs!=new_graph->graph_attrs) {
+                result.changed_subgraphs.push_back(path);
+            }
+            detail::diff_nodes(*old_graph, *new_graph, result);
+            detail::diff_edges(*old_graph, *new_graph, result);
+
+            auto after_subs = detail::keyed_subgraphs(*new_graph);
+            std::map<std::pair<std::string, std::size_t>, const dot_graph_resolved*> unmatched {after_subs.begin(), after_subs.end()};
+            std::vector<pending> matched;
+            for (const auto& [key, sub]: detail::keyed_subgraphs(*old_graph)) {
+                auto sub_path = path;
+                sub_path.push_back(key.first);
+                auto it = unmatched.find(key);
+                if (it==unmatched.end()) {
+                    result.removed_subgraphs.push_back(std::move(sub_path));
+                    continue;
+                }
+                matched.push_back(pending{sub, it->second, std::move(sub_path)});
+                unmatched.erase(it);
+            }
+            for (const auto& [key, sub]: after_subs) {
+                if (unmatched.contains(key)) {
+                    auto sub_path = path;
+                    sub_path.push_back(key.first);
+                    result.added_subgraphs.push_back(std::move(sub_path));
+                }
+            }
+            // reversed, so that subgraphs are visited in declaration order
+            stack.insert(stack.end(), std::make_move_iterator(matched.rbegin()), std::make_move_iterator(matched.rend()));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef DOT_PARSER_ANALYTICS_HPP
+#define DOT_PARSER_ANALYTICS_HPP
+
+#include "non_terminals.hpp"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// graph algorithms over a dense-id adjacency view of a flat graph
+// threads arguments work like resolve_options::threads: more than one runs on that many threads, 0 on one per core
+namespace dot_parser {
+    using vertex_id = std::uint32_t;
+    constexpr vertex_id no_vertex = std::numeric_limits<vertex_id>::max();
+
+    struct vertex_range {
+        const vertex_id* first;
+        const vertex_id* last;
+        [[nodiscard]] const vertex_id* begin() const { return first; }
+        [[nodiscard]] const vertex_id* end() const { return last; }
+        [[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(last-first); }
+    };
+
+    // compressed sparse row adjacency; vertex ids follow node declaration order, neighbors follow edge order
+    // undirected edges are stored in both directions, so in() is out() for them
+    struct graph_adjacency {
+        bool directed{};
+        std::size_t edge_count{};
+        std::vector<std::string_view> names;  // by vertex id; point into the flat graph, which must outlive this
+        std::vector<std::size_t> out_offsets;  // vertex_count()+1 entries
+        std::vector<vertex_id> out_targets;
+        std::vector<std::size_t> in_offsets;  // digraphs only
+        std::vector<vertex_id> in_sources;
+
+        [[nodiscard]] std::size_t vertex_count() const { return names.size(); }
+        [[nodiscard]] vertex_range out(vertex_id v) const {
+            return { out_targets.data()+out_offsets[v], out_targets.data()+out_offsets[v+1] };
+        }
+        [[nodiscard]] vertex_range in(vertex_id v) const {
+            return directed ? vertex_range{ in_sources.data()+in_offsets[v], in_sources.data()+in_offsets[v+1] } : out(v);
+        }
+    };
+    // edges may refer to nodes declared later on; throws for nodes that are never declared
+    graph_adjacency make_adjacency(const dot_graph_flat& graph, std::size_t threads=1);
+    graph_adjacency make_adjacency(dot_graph_flat&&, std::size_t=1) = delete;  // names would dangle
+
+    // (weakly) connected components: every vertex is labelled with the smallest id in its component
+    std::vector<vertex_id> connected_components(const graph_adjacency& graph, std::size_t threads=1);
+    // strongly connected components (Tarjan), numbered in reverse topological order of the condensation
+    std::vector<vertex_id> strongly_connected_components(const graph_adjacency& graph);
+    // Kahn's algorithm, taking sources in id order; empty if there is a cycle, self-loops included
+    // throws for undirected graphs
+    std::optional<std::vector<vertex_id>> topological_order(const graph_adjacency& graph);
+    bool has_cycle(const graph_adjacency& graph);
+
+    struct degree_distribution {
+        std::vector<std::size_t> out;  // out[d] vertices with out-degree d; the degree for undirected graphs
+        std::vector<std::size_t> in;  // digraphs only
+    };
+    degree_distribution degrees(const graph_adjacency& graph, std::size_t threads=1);
+    // hops from source along edge direction; no_vertex where unreachable
+    std::vector<vertex_id> bfs_distances(const graph_adjacency& graph, vertex_id source, std::size_t threads=1);
+}
+
+#endif //DOT_PARSER_ANALYTICS_HPP
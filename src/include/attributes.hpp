@@ -0,0 +1,86 @@
+#ifndef DOT_PARSER_ATTRIBUTES_HPP
+#define DOT_PARSER_ATTRIBUTES_HPP
+
+#include "non_terminals.hpp"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// typed view over attribute strings of resolved/flat graphs
+namespace dot_parser {
+    struct point {  // "x,y", or "x,y!" for a pinned position
+        double x{};
+        double y{};
+        bool pinned{};
+        bool operator==(const point& other) const { return x==other.x && y==other.y && pinned==other.pinned; }
+    };
+    struct color {  // "#rrggbb", "#rrggbbaa", "h,s,v" or one of a few common names
+        std::uint8_t r{};
+        std::uint8_t g{};
+        std::uint8_t b{};
+        std::uint8_t a{255};
+        bool operator==(const color& other) const { return r==other.r && g==other.g && b==other.b && a==other.a; }
+    };
+    // std::monostate stands for a missing or malformed value; enums and unknown attributes stay strings
+    using attr_value = std::variant<std::monostate, double, point, color, bool, std::string>;
+
+    enum class attr_kind { number, point, color, boolean, enumeration, string };
+    // type of well-known Graphviz attributes; anything else is a string
+    attr_kind kind_of(std::string_view key);
+
+    // decoders; nullopt for malformed input
+    std::optional<double> parse_number(std::string_view s);
+    std::optional<point> parse_point(std::string_view s);
+    std::optional<color> parse_color(std::string_view s);
+    std::optional<bool> parse_bool(std::string_view s);  // true/yes/false/no in any case, or an integer
+    attr_value decode(std::string_view key, std::string_view s);
+
+    // decodes attributes on first access and caches them next to the statement they belong to
+    // the graph must outlive the view and must not be modified meanwhile
+    class typed_attrs {
+    public:
+        explicit typed_attrs(const dot_graph_flat& graph);
+        explicit typed_attrs(const dot_graph_resolved& graph);
+        typed_attrs(dot_graph_flat&&) = delete;  // would dangle
+        typed_attrs(dot_graph_resolved&&) = delete;
+
+        [[nodiscard]] std::size_t node_count() const { return nodes.size(); }
+        [[nodiscard]] std::size_t edge_count() const { return edges.size(); }
+        [[nodiscard]] const std::string& node_name(std::size_t node) const { return nodes[node].stmt->node_name; }
+        [[nodiscard]] const edge& edge_at(std::size_t e) const { return *edges[e].first; }
+        [[nodiscard]] std::optional<std::size_t> node_id(const std::string& name) const;
+
+        const attr_value& node_attr(std::size_t node, const std::string& key);
+        const attr_value& edge_attr(std::size_t e, const std::string& key);
+        std::optional<double> node_number(std::size_t node, const std::string& key);
+        std::optional<double> edge_number(std::size_t e, const std::string& key);
+
+        // decode one attribute for all nodes/edges at once, indexed by node/edge id
+        std::vector<double> node_numbers(const std::string& key, double fallback=std::numeric_limits<double>::quiet_NaN());
+        std::vector<double> edge_numbers(const std::string& key, double fallback=std::numeric_limits<double>::quiet_NaN());
+
+    private:
+        struct entry {
+            const detail::attr_list_type* attrs;
+            std::vector<std::optional<attr_value>> cache;  // parallel to *attrs, allocated on first access
+            const attr_value& get(const std::string& key);
+        };
+        struct node_entry: entry {
+            const detail::node_stmt_v* stmt;
+        };
+        void add(const detail::node_stmt_v& v);
+        void add(const detail::edge_stmt_v& v);
+
+        std::vector<node_entry> nodes;
+        std::vector<entry> edge_stmts;
+        std::vector<std::pair<const edge*, std::size_t>> edges;  // (edge, index into edge_stmts)
+        std::unordered_map<std::string, std::size_t> node_ids;
+    };
+}
+
+#endif //DOT_PARSER_ATTRIBUTES_HPP
@@ -0,0 +1,112 @@
+#ifndef DOT_PARSER_FLAT_HASH_MAP_HPP
+#define DOT_PARSER_FLAT_HASH_MAP_HPP
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// open-addressing (linear probing) hash map for the resolver's bookkeeping
+// insert-only: there is no erase, so no tombstones either
+namespace dot_parser::detail {
+    template<typename Key, typename Value, typename Hash=std::hash<Key>, typename Eq=std::equal_to<Key>>
+    class flat_hash_map {
+    public:
+        flat_hash_map() = default;
+        explicit flat_hash_map(std::size_t expected) { reserve(expected); }
+
+        void reserve(std::size_t expected) {
+            std::size_t capacity = 16;
+            while (capacity*max_load_den < expected*max_load_num) {
+                capacity *= 2;
+            }
+            if (capacity > slots.size()) {
+                rehash(capacity);
+            }
+        }
+
+        // (value, true) if key was new, (existing value, false) otherwise
+        template<typename... Args>
+        std::pair<Value*, bool> try_emplace(const Key& key, Args&&... args) {
+            if ((count+1)*max_load_den > slots.size()*max_load_num) {
+                rehash(slots.empty() ? 16 : slots.size()*2);
+            }
+            auto h = hash_of(key);
+            auto i = probe(key, h);
+            if (hashes[i]!=empty) {
+                return {&slots[i].second, false};
+            }
+            hashes[i] = h;
+            slots[i] = std::pair<Key, Value>(key, Value(std::forward<Args>(args)...));
+            ++count;
+            return {&slots[i].second, true};
+        }
+
+        [[nodiscard]] const Value* find(const Key& key) const {
+            if (slots.empty()) {
+                return nullptr;
+            }
+            auto i = probe(key, hash_of(key));
+            return hashes[i]==empty ? nullptr : &slots[i].second;
+        }
+        [[nodiscard]] bool contains(const Key& key) const { return find(key)!=nullptr; }
+        [[nodiscard]] std::size_t size() const { return count; }
+
+    private:
+        static constexpr std::size_t empty = 0;
+        static constexpr std::size_t max_load_num = 7;  // grow past 7/8 full
+        static constexpr std::size_t max_load_den = 8;
+
+        [[nodiscard]] std::size_t hash_of(const Key& key) const {
+            auto h = Hash{}(key);
+            return h==empty ? 1 : h;  // 0 marks empty slots
+        }
+        // slot holding key, or the empty slot where it belongs
+        [[nodiscard]] std::size_t probe(const Key& key, std::size_t h) const {
+            auto mask = slots.size()-1;
+            for (auto i = (h * 0x9e3779b97f4a7c15ull >> 7) & mask; ; i = (i+1) & mask) {  // scramble weak std::hash values
+                if (hashes[i]==empty || (hashes[i]==h && Eq{}(slots[i].first, key))) {
+                    return i;
+                }
+            }
+        }
+        void rehash(std::size_t capacity) {
+            std::vector<std::size_t> old_hashes(capacity, empty);
+            std::vector<std::pair<Key, Value>> old_slots(capacity);
+            old_hashes.swap(hashes);
+            old_slots.swap(slots);
+            auto mask = capacity-1;
+            for (std::size_t j = 0; j < old_slots.size(); ++j) {
+                if (old_hashes[j]==empty) {
+                    continue;
+                }
+                auto i = (old_hashes[j] * 0x9e3779b97f4a7c15ull >> 7) & mask;
+                while (hashes[i]!=empty) {
+                    i = (i+1) & mask;
+                }
+                hashes[i] = old_hashes[j];
+                slots[i] = std::move(old_slots[j]);
+            }
+        }
+
+        std::vector<std::size_t> hashes;  // full hash per slot; empty if the slot is free
+        std::vector<std::pair<Key, Value>> slots;
+        std::size_t count = 0;
+    };
+
+    template<typename Key, typename Hash=std::hash<Key>, typename Eq=std::equal_to<Key>>
+    class flat_hash_set {
+    public:
+        flat_hash_set() = default;
+        explicit flat_hash_set(std::size_t expected): map{expected} {}
+        void reserve(std::size_t expected) { map.reserve(expected); }
+        bool insert(const Key& key) { return map.try_emplace(key).second; }  // true if key was new
+        [[nodiscard]] bool contains(const Key& key) const { return map.contains(key); }
+        [[nodiscard]] std::size_t size() const { return map.size(); }
+    private:
+        struct nothing {};
+        flat_hash_map<Key, nothing, Hash, Eq> map;
+    };
+}
+
+#endif //DOT_PARSER_FLAT_HASH_MAP_HPP
@@ -0,0 +1,36 @@
+#ifndef DOT_PARSER_DIFF_HPP
+#define DOT_PARSER_DIFF_HPP
+
+#include "non_terminals.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// structural (merkle-style) hashing and diffing of resolved graphs
+namespace dot_parser {
+    // changes between two resolved graphs; nodes and edges are compared within the subgraph declaring them
+    struct graph_diff {
+        std::vector<std::string> added_nodes;
+        std::vector<std::string> removed_nodes;
+        std::vector<std::string> changed_nodes;  // same name, different attributes
+        std::vector<edge> added_edges;
+        std::vector<edge> removed_edges;
+        std::vector<edge> changed_edges;
+        std::vector<subgraph_path> added_subgraphs;  // contents of added/removed subgraphs are not listed separately
+        std::vector<subgraph_path> removed_subgraphs;
+        std::vector<subgraph_path> changed_subgraphs;  // graph attributes differ
+        [[nodiscard]] bool empty() const;
+    };
+
+    // stable (FNV-1a based) hash over name, graph attrs, statements and the hashes of direct subgraphs
+    // subgraph hashes must be filled already; resolve does so with resolve_options::compute_hashes
+    std::uint64_t structural_hash(const dot_graph_resolved& graph);
+    // fills the hash of every (sub)graph of an already resolved graph
+    void compute_hashes(dot_graph_resolved& graph);
+
+    // subtrees with equal hashes are skipped, so the cost scales with the size of the change
+    // both graphs need their hashes computed
+    graph_diff diff(const dot_graph_resolved& before, const dot_graph_resolved& after);
+}
+
+#endif //DOT_PARSER_DIFF_HPP
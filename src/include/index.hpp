@@ -0,0 +1,46 @@
+#ifndef DOT_PARSER_INDEX_HPP
+#define DOT_PARSER_INDEX_HPP
+
+#include "non_terminals.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// inverted (key, value) -> node/edge index over a resolved graph
+// filled by resolve when resolve_options::index is set; attributes are the resolved (inherited) ones
+namespace dot_parser {
+    class attr_index {
+    public:
+        using path_type = dot_parser::subgraph_path;
+
+        // nodes/edges whose resolved attribute key equals value, in resolution order
+        [[nodiscard]] const std::vector<std::string>& nodes_with(const std::string& key, const std::string& value) const;
+        [[nodiscard]] const std::vector<edge>& edges_with(const std::string& key, const std::string& value) const;
+        // enclosing subgraphs of a node, built on each call; throws if the node is unknown
+        [[nodiscard]] path_type subgraph_path(const std::string& node) const;
+
+        // used by the resolver
+        std::size_t add_subgraph(std::size_t parent_path, const std::string& name);
+        void add_node(const detail::node_stmt_v& v, std::size_t path);
+        void add_edges(const detail::edge_stmt_v& v);
+        void clear();
+        // appends the entries of an index built for a later part of the same graph; its root is ours
+        void merge(attr_index&& other);
+
+        static constexpr std::size_t root_path = 0;
+    private:
+        template<typename T>
+        using table = std::unordered_map<std::string, std::unordered_map<std::string, std::vector<T>>>;
+        table<std::string> node_table;
+        table<edge> edge_table;
+        // subgraphs as (parent, name) links, so that deep nesting stays linear; root_path is the graph itself
+        struct path_entry {
+            std::size_t parent;
+            std::string name;
+        };
+        std::vector<path_entry> paths{ path_entry{root_path, ""} };
+        std::unordered_map<std::string, std::size_t> node_paths;
+    };
+}
+
+#endif //DOT_PARSER_INDEX_HPP
@@ -0,0 +1,76 @@
+#ifndef DOT_PARSER_MEMORY_HPP
+#define DOT_PARSER_MEMORY_HPP
+
+#include "non_terminals.hpp"
+#include <cstdint>
+#include <string_view>
+
+// heap accounting, slack trimming and string interning for parsed graphs
+namespace dot_parser {
+    // bytes held by a graph; containers count their capacity, not their size
+    struct memory_report {
+        std::size_t strings{};  // heap buffers of names, keys and values (short strings live inline and count as 0)
+        std::size_t attr_lists{};  // attribute vectors and graph attribute map nodes, without the strings
+        std::size_t edges{};  // edge vectors, without the strings
+        std::size_t containers{};  // statement vectors and the graph objects themselves
+        [[nodiscard]] std::size_t total() const { return strings+attr_lists+edges+containers; }
+    };
+
+    memory_report memory_usage(const dot_graph_raw& graph);
+    memory_report memory_usage(const dot_graph_resolved& graph);
+    memory_report memory_usage(const dot_graph_flat& graph);
+
+    // trims vector and string slack in place; returns the bytes released according to memory_usage
+    // equal strings stay separate copies, as std::string members can't share storage; see pack() for that
+    std::size_t compact(dot_graph_raw& graph);
+    std::size_t compact(dot_graph_resolved& graph);
+    std::size_t compact(dot_graph_flat& graph);
+
+    // immutable copy of a flat graph in five allocations: every distinct string (names, edge ops, keys and values)
+    // is stored once in a single buffer and referred to by id, statements, edges and attributes live in flat arrays
+    class packed_graph {
+    public:
+        using string_id = std::uint32_t;
+        struct attr {
+            string_id key;
+            string_id value;
+        };
+        struct packed_edge {
+            string_id src;
+            string_id edge_op;
+            string_id tgt;
+        };
+        // a node statement has one name and no edges, an edge statement edge_count edges from first_edge on
+        struct statement {
+            bool is_edge;
+            string_id node_name;
+            std::uint32_t first_edge;
+            std::uint32_t edge_count;
+            std::uint32_t first_attr;
+            std::uint32_t attr_count;
+        };
+
+        bool is_strict{};
+        string_id graph_type{};
+        std::vector<statement> statements;
+        std::vector<packed_edge> edges;
+        std::vector<attr> attrs;
+
+        [[nodiscard]] std::string_view str(string_id id) const {
+            return std::string_view{chars}.substr(offsets[id], offsets[id+1]-offsets[id]);
+        }
+        [[nodiscard]] std::size_t string_count() const { return offsets.size()-1; }
+        [[nodiscard]] dot_graph_flat unpack() const;
+
+    private:
+        std::string chars;  // distinct strings back to back
+        std::vector<std::uint32_t> offsets{0};  // string i is chars[offsets[i], offsets[i+1])
+        friend packed_graph pack(const dot_graph_flat& graph);
+        friend memory_report memory_usage(const packed_graph& graph);
+    };
+    // throws if the graph needs more than 32-bit ids or offsets
+    packed_graph pack(const dot_graph_flat& graph);
+    memory_report memory_usage(const packed_graph& graph);  // strings are the character buffer and its offsets
+}
+
+#endif //DOT_PARSER_MEMORY_HPP
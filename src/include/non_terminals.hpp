@@ -5,11 +5,17 @@
 #ifndef DOT_PARSER_NON_TERMINALS_HPP
 #define DOT_PARSER_NON_TERMINALS_HPP
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
 #include <variant>
 
+// maximal subgraph nesting accepted by the parser and the resolver
+#ifndef DOT_PARSER_MAX_DEPTH
+#define DOT_PARSER_MAX_DEPTH 1024
+#endif
+
 namespace dot_parser {
     struct edge {
         std::string src;
@@ -56,18 +62,36 @@ namespace dot_parser::detail {
         stmt_v(const node_stmt_v& v): val{v} {};
         stmt_v(const edge_stmt_v& v): val{v} {};
         stmt_v(const std::variant<attr_stmt_v, node_stmt_v, attr_item_v>& v);
-        stmt_v(const std::vector<stmt_v>& v): val{v} {};
-        stmt_v(std::string name, const std::vector<stmt_v>& v): name{std::move(name)}, val{v} {}
+        stmt_v(std::vector<stmt_v> v): val{std::move(v)} {};
+        stmt_v(std::string name, std::vector<stmt_v> v): name{std::move(name)}, val{std::move(v)} {}
+        // copies and destruction are non-recursive, so that deeply nested subgraphs don't blow the stack
+        stmt_v(const stmt_v& other);
+        stmt_v(stmt_v&&) noexcept = default;
+        stmt_v& operator=(const stmt_v& other);
+        stmt_v& operator=(stmt_v&&) noexcept = default;
+        ~stmt_v();
     };
 }
 
 namespace dot_parser {
+    // statement counts recorded by the parser, used to pre-size containers
+    struct graph_stats {
+        std::size_t node_stmts{};
+        std::size_t edge_stmts{};
+        std::size_t edges{};  // after expanding node groups and chains
+        std::size_t subgraphs{};
+        std::size_t attr_items{};  // in attr lists and 'ID'='ID' statements
+    };
+
+    using subgraph_path = std::vector<std::string>;  // names of nested subgraphs, outermost first; "" for unnamed ones
+
     // raw graph from the parser directly
     struct dot_graph_raw {
         bool is_strict{};
         std::string graph_type;  // graph or digraph
         std::string name;
         std::vector<detail::stmt_v> statements;
+        graph_stats stats;
     };
 
     namespace detail {  // used for collecting attributes from outer scope
@@ -82,12 +106,30 @@ namespace dot_parser {
     struct dot_graph_resolved;
     using resolved_stmt_type = std::variant<detail::node_stmt_v, detail::edge_stmt_v, dot_graph_resolved>;
 
+    namespace detail {
+        // statements of a resolved graph; a plain vector apart from copying and tearing down nested subgraphs
+        // without recursion, which keeps dot_graph_resolved itself an aggregate
+        struct resolved_stmt_list: std::vector<resolved_stmt_type> {
+            using std::vector<resolved_stmt_type>::vector;
+            resolved_stmt_list() = default;
+            resolved_stmt_list(std::vector<resolved_stmt_type> v) noexcept;
+            // out of line, where dot_graph_resolved is complete
+            resolved_stmt_list(const resolved_stmt_list& other);
+            resolved_stmt_list(resolved_stmt_list&& other) noexcept;
+            resolved_stmt_list& operator=(const resolved_stmt_list& other);
+            resolved_stmt_list& operator=(resolved_stmt_list&& other) noexcept;
+            ~resolved_stmt_list();
+        };
+    }
+
     struct dot_graph_resolved {
         bool is_strict{};
         std::string graph_type;
         std::string name;
         std::map<std::string, std::string> graph_attrs;
-        std::vector<resolved_stmt_type> statements;
+        detail::resolved_stmt_list statements;
+        std::uint64_t hash{};  // structural hash of this subtree; 0 unless resolve_options::compute_hashes is set
+        graph_stats stats;  // of the raw graph; top-level graph only
     };
 
     // flatten out subgraph statements, discarding sub-graph attributes at the same time
@@ -0,0 +1,74 @@
+#ifndef DOT_PARSER_PARTITION_HPP
+#define DOT_PARSER_PARTITION_HPP
+
+#include "non_terminals.hpp"
+#include "detail/flat_hash_map.hpp"
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+// splitting resolved or flat graphs into k balanced shards, and writing the shards out
+namespace dot_parser {
+    namespace detail {
+        struct partition_builder;
+    }
+
+    struct shard_load {
+        std::size_t nodes{};
+        std::size_t edges{};
+    };
+
+    // an edge with at least one end owned by another shard than the edge statement holding it
+    struct cut_edge {
+        const edge* e;  // points into the partitioned graph
+        std::size_t shard;  // where the edge is written
+        std::size_t src_shard;
+        std::size_t tgt_shard;
+    };
+
+    // placement of every node/edge statement of a graph; refers into that graph, which must outlive it unchanged
+    class graph_partition {
+    public:
+        [[nodiscard]] std::size_t shard_count() const { return shard_loads.size(); }
+        [[nodiscard]] const std::vector<shard_load>& loads() const { return shard_loads; }
+        [[nodiscard]] const std::vector<cut_edge>& cut_edges() const { return cuts; }
+        // throw if the node is unknown
+        [[nodiscard]] std::size_t node_shard(std::string_view node) const;
+        [[nodiscard]] std::uint64_t node_id(std::string_view node) const;  // dense, in declaration order
+
+        // shard of each node/edge statement, in document order (subgraphs walked depth-first)
+        [[nodiscard]] const std::vector<std::uint32_t>& statement_shards() const { return stmt_shards; }
+
+        struct node_entry {
+            std::uint64_t id;
+            std::uint32_t shard;
+        };
+    private:
+        std::vector<shard_load> shard_loads;
+        std::vector<cut_edge> cuts;
+        std::vector<std::uint32_t> stmt_shards;
+        detail::flat_hash_map<std::string_view, node_entry> node_entries;
+        friend struct detail::partition_builder;
+    };
+
+    // subgraphs weighing (nodes+edges) no more than an even share stay whole and are placed largest first on
+    // the lightest shard; heavier ones are split into their statements, and loose statements fill up the
+    // shards in document order so that neighbours stay together; linear apart from sorting the kept subgraphs
+    // edges stay with their statement; the ones reaching into other shards are listed as cut edges
+    graph_partition partition(const dot_graph_resolved& graph, std::size_t shards);
+    graph_partition partition(const dot_graph_flat& graph, std::size_t shards);
+
+    // both writers stream in a single pass over the graph; out[i] receives shard i and may be null to skip it
+    // the graph must be the partitioned one
+
+    // standalone DOT per shard: its statements with resolved attributes, subgraphs that lost statements to
+    // other shards repeated around the remaining ones, and bare declarations of foreign ends of cut edges first
+    void write_dot(const dot_graph_resolved& graph, const graph_partition& parts, const std::vector<std::ostream*>& out);
+    void write_dot(const dot_graph_flat& graph, const graph_partition& parts, const std::vector<std::ostream*>& out);
+    // edges of each shard, cut edges included, as pairs of little-endian uint64 node ids (source, target)
+    void write_edge_list(const dot_graph_resolved& graph, const graph_partition& parts, const std::vector<std::ostream*>& out);
+    void write_edge_list(const dot_graph_flat& graph, const graph_partition& parts, const std::vector<std::ostream*>& out);
+}
+
+#endif //DOT_PARSER_PARTITION_HPP
@@ -2,19 +2,63 @@
 #define DOT_PARSER_RESOLVER_HPP
 
 #include "non_terminals.hpp"
-#include <unordered_set>
+#include "index.hpp"
+#include "detail/flat_hash_map.hpp"
+#include <memory>
+#include <string_view>
 
 // resolve node/edge/graph attributes from dot_graph_raw
 // after calling resolve, only possible (non-recursive) statements are node/edge stmts(cuz attrs are resolved)
 namespace dot_parser {
+    struct resolve_options {
+        std::size_t max_depth = DOT_PARSER_MAX_DEPTH;  // throws if subgraphs are nested deeper
+        attr_index* index = nullptr;  // cleared and filled during resolution if set
+        bool compute_hashes = false;  // fill dot_graph_resolved::hash for every (sub)graph, see diff.hpp
+        // more than one resolves top-level subgraphs on a thread pool (0 for one thread per core)
+        // the result, errors included, is the same as with a single thread
+        std::size_t threads = 1;
+    };
+
     namespace detail {
-        // recursive helper of resolve
+        // the resolver's sets refer into the raw graph instead of copying names and edges
+        struct edge_ref_hash {
+            std::size_t operator()(const edge* e) const { return e->hash(); }
+        };
+        struct edge_ref_eq {
+            bool operator()(const edge* a, const edge* b) const { return *a==*b; }
+        };
+        using node_set = flat_hash_set<std::string_view>;
+        using edge_set = flat_hash_set<const edge*, edge_ref_hash, edge_ref_eq>;
+
+        // helper of resolve; walks subgraphs with an explicit stack instead of recursing
         dot_graph_resolved resolve_impl(const dot_graph_raw& raw_graph,
                                         external_attrs ext_attrs,
-                                        std::unordered_set<std::string>& nodes_seen,
-                                        std::unordered_set<edge>& edges_seen);
+                                        node_set& nodes_seen,
+                                        edge_set& edges_seen,
+                                        const resolve_options& options);
+    }
+    dot_graph_resolved resolve(const dot_graph_raw& raw_graph, const resolve_options& options={});
+
+    namespace detail {
+        struct scope_cache;
     }
-    dot_graph_resolved resolve(const dot_graph_raw& raw_graph);
+    // resolves single subgraphs of a raw graph on demand, with the same result and errors as the matching
+    // subtree of resolve; declaration order is recorded in one walk that only goes as far as the end of the
+    // subgraphs looked up so far, and scopes are memoized, so repeated lookups only touch the subgraph
+    // the raw graph must outlive the resolver and stay unchanged; not thread-safe
+    class subgraph_resolver {
+    public:
+        explicit subgraph_resolver(const dot_graph_raw& raw_graph, resolve_options options={});
+        subgraph_resolver(dot_graph_raw&&, resolve_options={}) = delete;  // would dangle
+        ~subgraph_resolver();
+        // path names nested subgraphs from the top level, taking the first match on each level; throws if not found
+        // an index in the options receives the subgraph's statements only
+        dot_graph_resolved resolve(const subgraph_path& path);
+    private:
+        const dot_graph_raw& raw_graph;
+        resolve_options options;
+        std::unique_ptr<detail::scope_cache> cache;
+    };
 
     dot_graph_flat flatten(const dot_graph_resolved& resolved_graph);
 }
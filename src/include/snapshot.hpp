@@ -0,0 +1,59 @@
+#ifndef DOT_PARSER_SNAPSHOT_HPP
+#define DOT_PARSER_SNAPSHOT_HPP
+
+#include "non_terminals.hpp"
+#include "resolver.hpp"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// hot-reloadable, immutable graph snapshots for long-running readers
+namespace dot_parser {
+    struct graph_snapshot {
+        dot_graph_resolved resolved;
+        dot_graph_flat flat;
+        std::uint64_t version{};  // 1 for the first snapshot published by a holder, counting up
+        std::uint64_t generation{};  // order in which its reload was requested
+    };
+
+    // readers take the current snapshot with get() and keep using it for as long as they hold the pointer;
+    // a reload builds the next snapshot off to the side and swaps it in with an atomic compare-exchange,
+    // so readers never wait for parsing or resolving; a snapshot is freed when its last holder lets go
+    // reloads that overlap are published in the order they were requested: one that finishes after a later
+    // requested one has been published is dropped, and returns that newer snapshot instead
+    class snapshot_holder {
+    public:
+        using snapshot_ptr = std::shared_ptr<const graph_snapshot>;
+
+        explicit snapshot_holder(resolve_options options={});
+        ~snapshot_holder();  // waits for background reloads still running
+
+        // nullptr until the first successful reload; safe to call from any thread
+        [[nodiscard]] snapshot_ptr get() const;
+
+        // parse, resolve and flatten on the calling thread, then publish
+        // on failure the exception propagates and the current snapshot stays in place
+        snapshot_ptr reload(const std::string& input);
+        snapshot_ptr reload_file(const std::string& path);
+        // same on a background thread; the request is ordered on the calling thread
+        // the future carries the published snapshot or the error
+        std::future<snapshot_ptr> reload_file_async(const std::string& path);
+        // publish an already resolved graph
+        snapshot_ptr publish(dot_graph_resolved resolved);
+
+    private:
+        snapshot_ptr publish(dot_graph_resolved resolved, std::uint64_t generation);
+
+        snapshot_ptr current;  // only touched through the std::atomic_* functions for shared_ptr
+        resolve_options options;
+        std::atomic<std::uint64_t> generations{0};  // handed out to reloads as they are requested
+        std::mutex pending_mutex;
+        std::vector<std::future<void>> pending;  // background reloads, joined on destruction
+    };
+}
+
+#endif //DOT_PARSER_SNAPSHOT_HPP
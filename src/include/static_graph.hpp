@@ -0,0 +1,427 @@
+#ifndef DOT_PARSER_STATIC_GRAPH_HPP
+#define DOT_PARSER_STATIC_GRAPH_HPP
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+// compile-time parsing of small DOT literals into fixed-size tables; nothing is allocated
+//
+//   constexpr auto machine = DOT_PARSER_STATIC_GRAPH("digraph { idle; run; idle -> run [label=start] }");
+//   static_assert(machine.edge_attr(0, "label")==std::string_view{"start"});
+//
+// a malformed literal fails to compile; the error points at the throw naming the reason
+// supported: strict, graph/digraph, an optional graph name, node statements, edge chains, attribute lists,
+// 'ID'='ID' items, graph/node/edge attribute statements and comments
+// not supported (compile errors as well): subgraphs, node groups and escapes in quoted names
+// checks follow resolve: nodes are declared before use and only once, edge ops match the graph type,
+// strict graphs have no duplicate edges; node/edge defaults are applied when looking attributes up
+namespace dot_parser {
+    struct static_attr {
+        std::string_view key;
+        std::string_view value;
+    };
+    // attribute ranges index static_graph::attrs; positions count statements, to order defaults
+    struct static_node {
+        std::string_view name;
+        std::size_t first_attr{};
+        std::size_t attr_count{};
+        std::size_t position{};
+    };
+    struct static_edge {
+        std::size_t src{};  // node indices
+        std::size_t tgt{};
+        std::size_t first_attr{};
+        std::size_t attr_count{};
+        std::size_t position{};
+    };
+    struct static_defaults {  // node [...] or edge [...]
+        bool for_nodes{};
+        std::size_t first_attr{};
+        std::size_t attr_count{};
+        std::size_t position{};
+    };
+
+    // lookups are linear scans, which is fine for the graph sizes this is meant for
+    template<std::size_t Nodes, std::size_t Edges, std::size_t Attrs, std::size_t Defaults, std::size_t GraphAttrs>
+    struct static_graph {
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        bool is_strict{};
+        bool directed{};
+        std::string_view name;
+        std::array<static_node, Nodes> nodes{};
+        std::array<static_edge, Edges> edges{};
+        std::array<static_attr, Attrs> attrs{};  // own attributes of nodes, edges and defaults
+        std::array<static_defaults, Defaults> defaults{};
+        std::array<static_attr, GraphAttrs> graph_attrs{};  // in declaration order; later ones win
+
+        [[nodiscard]] constexpr std::size_t node_index(std::string_view node) const {
+            for (std::size_t i = 0; i < Nodes; ++i) {
+                if (nodes[i].name==node) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+        // own attributes first (the first of repeated keys wins), then the latest default set before the statement
+        [[nodiscard]] constexpr std::optional<std::string_view> node_attr(std::size_t node, std::string_view key) const {
+            const auto& n = nodes[node];
+            return lookup(n.first_attr, n.attr_count, n.position, true, key);
+        }
+        [[nodiscard]] constexpr std::optional<std::string_view> edge_attr(std::size_t edge, std::string_view key) const {
+            const auto& e = edges[edge];
+            return lookup(e.first_attr, e.attr_count, e.position, false, key);
+        }
+        [[nodiscard]] constexpr std::optional<std::string_view> graph_attr(std::string_view key) const {
+            for (std::size_t i = GraphAttrs; i > 0; --i) {
+                if (graph_attrs[i-1].key==key) {
+                    return graph_attrs[i-1].value;
+                }
+            }
+            return std::nullopt;
+        }
+
+    private:
+        [[nodiscard]] constexpr std::optional<std::string_view> lookup(std::size_t first, std::size_t count, std::size_t position,
+                                                                     bool for_nodes, std::string_view key) const {
+            for (auto i = first; i < first+count; ++i) {
+                if (attrs[i].key==key) {
+                    return attrs[i].value;
+                }
+            }
+            for (std::size_t d = Defaults; d > 0; --d) {
+                const auto& defs = defaults[d-1];
+                if (defs.for_nodes!=for_nodes || defs.position>position) {
+                    continue;
+                }
+                for (auto i = defs.first_attr+defs.attr_count; i > defs.first_attr; --i) {
+                    if (attrs[i-1].key==key) {
+                        return attrs[i-1].value;
+                    }
+                }
+            }
+            return std::nullopt;
+        }
+    };
+
+    namespace detail {
+        // first pass: table sizes only
+        struct static_counts {
+            std::size_t nodes{};
+            std::size_t edges{};
+            std::size_t attrs{};
+            std::size_t defaults{};
+            std::size_t graph_attrs{};
+
+            constexpr void header(bool, bool, std::string_view) {}
+            constexpr void add_attr(std::string_view, std::string_view) { ++attrs; }
+            constexpr void add_graph_attr(std::string_view, std::string_view) { ++graph_attrs; }
+            constexpr void add_defaults(bool, std::size_t, std::size_t, std::size_t) { ++defaults; }
+            constexpr void add_node(std::string_view, std::size_t, std::size_t, std::size_t) { ++nodes; }
+            constexpr void add_edge(std::string_view, std::string_view, std::size_t) { ++edges; }
+            constexpr void set_edge_attrs(std::size_t, std::size_t, std::size_t) {}
+        };
+
+        // second pass: fills tables sized by the first one, and checks what resolve would check
+        template<typename Graph>
+        struct static_filler {
+            Graph graph{};
+            static_counts filled{};
+
+            constexpr void header(bool is_strict, bool directed, std::string_view name) {
+                graph.is_strict = is_strict;
+                graph.directed = directed;
+                graph.name = name;
+            }
+            constexpr void add_attr(std::string_view key, std::string_view value) {
+                graph.attrs[filled.attrs++] = static_attr{key, value};
+            }
+            constexpr void add_graph_attr(std::string_view key, std::string_view value) {
+                graph.graph_attrs[filled.graph_attrs++] = static_attr{key, value};
+            }
+            constexpr void add_defaults(bool for_nodes, std::size_t first, std::size_t count, std::size_t position) {
+                graph.defaults[filled.defaults++] = static_defaults{for_nodes, first, count, position};
+            }
+            constexpr void add_node(std::string_view name, std::size_t first, std::size_t count, std::size_t position) {
+                for (std::size_t i = 0; i < filled.nodes; ++i) {
+                    if (graph.nodes[i].name==name) {
+                        throw std::runtime_error("redefining node");
+                    }
+                }
+                graph.nodes[filled.nodes++] = static_node{name, first, count, position};
+            }
+            constexpr void add_edge(std::string_view src, std::string_view tgt, std::size_t position) {
+                auto s = find(src);
+                auto t = find(tgt);
+                if (s==Graph::npos || t==Graph::npos) {
+                    throw std::runtime_error("edge contains undefined node(s)");
+                }
+                if (graph.is_strict) {
+                    for (std::size_t i = 0; i < filled.edges; ++i) {
+                        const auto& e = graph.edges[i];
+                        if ((e.src==s && e.tgt==t) || (!graph.directed && e.src==t && e.tgt==s)) {
+                            throw std::runtime_error("duplicate edges for a strict graph");
+                        }
+                    }
+                }
+                graph.edges[filled.edges++] = static_edge{s, t, 0, 0, position};
+            }
+            constexpr void set_edge_attrs(std::size_t from_edge, std::size_t first, std::size_t count) {
+                for (auto i = from_edge; i < filled.edges; ++i) {
+                    graph.edges[i].first_attr = first;
+                    graph.edges[i].attr_count = count;
+                }
+            }
+            [[nodiscard]] constexpr std::size_t find(std::string_view name) const {
+                for (std::size_t i = 0; i < filled.nodes; ++i) {
+                    if (graph.nodes[i].name==name) {
+                        return i;
+                    }
+                }
+                return Graph::npos;
+            }
+        };
+
+        // hand-written scanner for the subset, shared by both passes
+        template<typename Tables>
+        class static_parser {
+        public:
+            constexpr static_parser(std::string_view input, Tables& tables): input{input}, tables{tables} {}
+
+            constexpr void parse() {
+                skip();
+                bool is_strict = false;
+                auto keyword = plain_id();
+                if (keyword=="strict") {
+                    is_strict = true;
+                    skip();
+                    keyword = plain_id();
+                }
+                if (keyword!="graph" && keyword!="digraph") {
+                    throw std::runtime_error("expected graph or digraph");
+                }
+                directed = keyword=="digraph";
+                skip();
+                std::string_view name;
+                if (peek()!='{') {
+                    name = id();
+                    skip();
+                }
+                tables.header(is_strict, directed, name);
+                expect('{');
+                skip();
+                while (peek()!='}') {
+                    statement();
+                    skip();
+                    if (peek()==';') {
+                        ++pos;
+                        skip();
+                    }
+                }
+                ++pos;
+                skip();
+                if (pos!=input.size()) {
+                    throw std::runtime_error("unexpected input after the graph");
+                }
+            }
+
+        private:
+            [[nodiscard]] constexpr char peek() const {
+                if (pos>=input.size()) {
+                    throw std::runtime_error("unexpected end of input");
+                }
+                return input[pos];
+            }
+            [[nodiscard]] constexpr bool at(std::string_view s) const {
+                return input.substr(pos, s.size())==s;
+            }
+            constexpr void expect(char c) {
+                if (peek()!=c) {
+                    throw std::runtime_error("unexpected character");
+                }
+                ++pos;
+            }
+            // whitespace, line breaks and comments
+            constexpr void skip() {
+                while (pos<input.size()) {
+                    auto c = input[pos];
+                    if (c==' ' || c=='\t' || c=='\n' || c=='\r') {
+                        ++pos;
+                    } else if (at("//")) {
+                        while (pos<input.size() && input[pos]!='\n') {
+                            ++pos;
+                        }
+                    } else if (at("/*")) {
+                        auto end = input.find("*/", pos+2);
+                        if (end==std::string_view::npos) {
+                            throw std::runtime_error("unterminated comment");
+                        }
+                        pos = end+2;
+                    } else {
+                        return;
+                    }
+                }
+            }
+            // the unquoted name characters of the grammar in detail/grammar.hpp
+            [[nodiscard]] static constexpr bool is_plain(char c) {
+                return (c>='a' && c<='z') || (c>='A' && c<='Z') || (c>='0' && c<='9') || c=='_'
+                    || std::string_view{"+*.:!?$%&@()<>'`|^~\\"}.find(c)!=std::string_view::npos;
+            }
+            constexpr std::string_view plain_id() {
+                auto begin = pos;
+                while (pos<input.size() && is_plain(input[pos])) {
+                    ++pos;
+                }
+                if (pos==begin) {
+                    throw std::runtime_error("expected a name");
+                }
+                return input.substr(begin, pos-begin);
+            }
+            constexpr std::string_view id() {
+                if (peek()!='"') {
+                    return plain_id();
+                }
+                auto begin = ++pos;
+                while (peek()!='"') {
+                    if (input[pos]=='\\') {
+                        throw std::runtime_error("escapes are not supported in static graphs");
+                    }
+                    if (static_cast<unsigned char>(input[pos])<0x20) {
+                        throw std::runtime_error("control character in a quoted name");
+                    }
+                    ++pos;
+                }
+                return input.substr(begin, pos++ - begin);
+            }
+            // [a=b, c=d]; returns the number of items added, to the graph attributes for graph [...]
+            constexpr std::size_t attr_list(bool for_graph=false) {
+                std::size_t count = 0;
+                skip();
+                if (pos>=input.size() || input[pos]!='[') {
+                    return 0;
+                }
+                ++pos;
+                skip();
+                while (peek()!=']') {
+                    auto key = id();
+                    skip();
+                    expect('=');
+                    skip();
+                    auto value = id();
+                    if (for_graph) {
+                        tables.add_graph_attr(key, value);
+                    } else {
+                        tables.add_attr(key, value);
+                        ++count;
+                    }
+                    skip();
+                    if (peek()==',' || peek()==';') {
+                        ++pos;
+                        skip();
+                    }
+                }
+                ++pos;
+                return count;
+            }
+            constexpr void statement() {
+                if (peek()=='{') {
+                    throw std::runtime_error("subgraphs and node groups are not supported in static graphs");
+                }
+                bool quoted = peek()=='"';
+                auto first = id();
+                if (!quoted && first=="subgraph") {
+                    throw std::runtime_error("subgraphs and node groups are not supported in static graphs");
+                }
+                if (!quoted && first=="graph") {
+                    attr_list(true);
+                    ++position;
+                    return;
+                }
+                if (!quoted && (first=="node" || first=="edge")) {
+                    auto begin = attrs;
+                    auto count = attr_list();
+                    attrs += count;
+                    tables.add_defaults(first=="node", begin, count, position);
+                    ++position;
+                    return;
+                }
+                skip();
+                if (peek()=='=') {
+                    ++pos;
+                    skip();
+                    tables.add_graph_attr(first, id());
+                } else if (at("->") || at("--")) {
+                    auto from_edge = edges;
+                    auto src = first;
+                    while (at("->") || at("--")) {
+                        if (at("->")!=directed) {
+                            throw std::runtime_error(directed ? "undirected edge in a directed graph" : "directed edge in an undirected graph");
+                        }
+                        pos += 2;
+                        skip();
+                        if (peek()=='{') {
+                            throw std::runtime_error("subgraphs and node groups are not supported in static graphs");
+                        }
+                        auto tgt = id();
+                        tables.add_edge(src, tgt, position);
+                        ++edges;
+                        src = tgt;
+                        skip();
+                    }
+                    auto begin = attrs;
+                    auto count = attr_list();
+                    attrs += count;
+                    tables.set_edge_attrs(from_edge, begin, count);
+                } else {
+                    auto begin = attrs;
+                    auto count = attr_list();
+                    attrs += count;
+                    tables.add_node(first, begin, count, position);
+                }
+                ++position;
+            }
+            std::string_view input;
+            Tables& tables;
+            std::size_t pos{};
+            std::size_t attrs{};  // entries in the attribute table so far
+            std::size_t edges{};
+            std::size_t position{};
+            bool directed{};
+        };
+
+        constexpr static_counts measure_static(std::string_view input) {
+            static_counts counts{};
+            static_parser<static_counts> parser{input, counts};
+            parser.parse();
+            return counts;
+        }
+    }
+
+    // use DOT_PARSER_STATIC_GRAPH, which measures the literal first
+    template<std::size_t Nodes, std::size_t Edges, std::size_t Attrs, std::size_t Defaults, std::size_t GraphAttrs>
+    constexpr static_graph<Nodes, Edges, Attrs, Defaults, GraphAttrs> parse_static(std::string_view input) {
+        detail::static_filler<static_graph<Nodes, Edges, Attrs, Defaults, GraphAttrs>> filler{};
+        detail::static_parser<decltype(filler)> parser{input, filler};
+        parser.parse();
+        return filler.graph;
+    }
+}
+
+// parses in a constexpr variable of its own, so that the literal is parsed at compile time (and a malformed one
+// fails to compile) whether or not the result is assigned to a constexpr variable
+// literal is a string literal or a constexpr character array with static storage duration
+#define DOT_PARSER_STATIC_GRAPH(literal) \
+    ([] { \
+        constexpr auto dot_parser_static_graph = ::dot_parser::parse_static< \
+            ::dot_parser::detail::measure_static(literal).nodes, \
+            ::dot_parser::detail::measure_static(literal).edges, \
+            ::dot_parser::detail::measure_static(literal).attrs, \
+            ::dot_parser::detail::measure_static(literal).defaults, \
+            ::dot_parser::detail::measure_static(literal).graph_attrs>(literal); \
+        return dot_parser_static_graph; \
+    }())
+
+#endif //DOT_PARSER_STATIC_GRAPH_HPP
@@ -0,0 +1,92 @@
+#include "index.hpp"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace dot_parser {
+    namespace detail {
+        template<typename T, typename Table>
+        const std::vector<T>& lookup(const Table& table, const std::string& key, const std::string& value) {
+            static const std::vector<T> empty;
+            auto key_it = table.find(key);
+            if (key_it==table.end()) {
+                return empty;
+            }
+            auto value_it = key_it->second.find(value);
+            if (value_it==key_it->second.end()) {
+                return empty;
+            }
+            return value_it->second;
+        }
+    }
+
+    const std::vector<std::string>& attr_index::nodes_with(const std::string& key, const std::string& value) const {
+        return detail::lookup<std::string>(node_table, key, value);
+    }
+
+    const std::vector<edge>& attr_index::edges_with(const std::string& key, const std::string& value) const {
+        return detail::lookup<edge>(edge_table, key, value);
+    }
+
+    attr_index::path_type attr_index::subgraph_path(const std::string& node) const {
+        auto it = node_paths.find(node);
+        if (it==node_paths.end()) {
+            throw std::runtime_error("node not in index: " + node);
+        }
+        path_type path;
+        for (auto at = it->second; at!=root_path; at = paths[at].parent) {
+            path.push_back(paths[at].name);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    std::size_t attr_index::add_subgraph(std::size_t parent_path, const std::string& name) {
+        paths.push_back(path_entry{parent_path, name});
+        return paths.size()-1;
+    }
+
+    void attr_index::add_node(const detail::node_stmt_v& v, std::size_t path) {
+        for (const auto& [key, value]: v.attrs) {
+            node_table[key][value].push_back(v.node_name);
+        }
+        node_paths.insert_or_assign(v.node_name, path);
+    }
+
+    void attr_index::add_edges(const detail::edge_stmt_v& v) {
+        for (const auto& [key, value]: v.attrs) {
+            auto& edges = edge_table[key][value];
+            edges.insert(edges.end(), v.edges.begin(), v.edges.end());
+        }
+    }
+
+    void attr_index::merge(attr_index&& other) {
+        auto offset = paths.size()-1;  // other's paths, less its root
+        auto rebase = [offset](std::size_t path) { return path==root_path ? root_path : path+offset; };
+        for (auto it = other.paths.begin()+1; it!=other.paths.end(); ++it) {
+            paths.push_back(path_entry{rebase(it->parent), std::move(it->name)});
+        }
+        for (const auto& [node, path]: other.node_paths) {
+            node_paths.insert_or_assign(node, rebase(path));
+        }
+        auto append = [](auto& table, auto& other_table) {
+            for (auto& [key, values]: other_table) {
+                auto& into = table[key];
+                for (auto& [value, items]: values) {
+                    auto& dst = into[value];
+                    dst.insert(dst.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+                }
+            }
+        };
+        append(node_table, other.node_table);
+        append(edge_table, other.edge_table);
+        other.clear();
+    }
+
+    void attr_index::clear() {
+        node_table.clear();
+        edge_table.clear();
+        paths.assign(1, path_entry{root_path, ""});
+        node_paths.clear();
+    }
+}
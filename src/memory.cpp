@@ -0,0 +1,320 @@
+#include "memory.hpp"
+#include "detail/flat_hash_map.hpp"
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace dot_parser {
+    namespace detail {
+        // libstdc++/libc++ red-black tree nodes carry a color and three pointers next to the value
+        constexpr std::size_t map_node_overhead = 4*sizeof(void*);
+
+        std::size_t heap_bytes(const std::string& s) {
+            static const auto inline_capacity = std::string{}.capacity();
+            return s.capacity()>inline_capacity ? s.capacity()+1 : 0;
+        }
+        template<typename T>
+        std::size_t heap_bytes(const std::vector<T>& v) {
+            return v.capacity()*sizeof(T);
+        }
+
+        void account(memory_report& report, const attr_list_type& attrs) {
+            report.attr_lists += heap_bytes(attrs);
+            for (const auto& [key, value]: attrs) {
+                report.strings += heap_bytes(key) + heap_bytes(value);
+            }
+        }
+        void account(memory_report& report, const std::map<std::string, std::string>& attrs) {
+            report.attr_lists += attrs.size()*(sizeof(attr_item_v)+map_node_overhead);
+            for (const auto& [key, value]: attrs) {
+                report.strings += heap_bytes(key) + heap_bytes(value);
+            }
+        }
+        void account(memory_report& report, const node_stmt_v& v) {
+            report.strings += heap_bytes(v.node_name);
+            account(report, v.attrs);
+        }
+        void account(memory_report& report, const edge_stmt_v& v) {
+            report.edges += heap_bytes(v.edges);
+            for (const auto& e: v.edges) {
+                report.strings += heap_bytes(e.src) + heap_bytes(e.edge_op) + heap_bytes(e.tgt);
+            }
+            account(report, v.attrs);
+        }
+        void account(memory_report& report, const attr_stmt_v& v) {
+            report.strings += heap_bytes(v.type);
+            account(report, v.attrs);
+        }
+        void account(memory_report& report, const attr_item_v& v) {
+            report.strings += heap_bytes(v.first) + heap_bytes(v.second);
+        }
+
+        void shrink(attr_list_type& attrs) {
+            attrs.shrink_to_fit();
+            for (auto& [key, value]: attrs) {
+                key.shrink_to_fit();
+                value.shrink_to_fit();
+            }
+        }
+        void shrink(node_stmt_v& v) {
+            v.node_name.shrink_to_fit();
+            shrink(v.attrs);
+        }
+        void shrink(edge_stmt_v& v) {
+            v.edges.shrink_to_fit();
+            for (auto& e: v.edges) {
+                e.src.shrink_to_fit();
+                e.edge_op.shrink_to_fit();
+                e.tgt.shrink_to_fit();
+            }
+            shrink(v.attrs);
+        }
+        void shrink(attr_stmt_v& v) {
+            v.type.shrink_to_fit();
+            shrink(v.attrs);
+        }
+        void shrink(attr_item_v& v) {
+            v.first.shrink_to_fit();
+            v.second.shrink_to_fit();
+        }
+    }
+
+    memory_report memory_usage(const dot_graph_raw& graph) {
+        memory_report report;
+        report.containers += sizeof(graph);
+        report.strings += detail::heap_bytes(graph.graph_type) + detail::heap_bytes(graph.name);
+        // subgraphs with an explicit stack, see stmt_v::~stmt_v
+        std::vector<const std::vector<detail::stmt_v>*> pending {&graph.statements};
+        while (!pending.empty()) {
+            const auto* stmts = pending.back();
+            pending.pop_back();
+            report.containers += detail::heap_bytes(*stmts);
+            for (const auto& stmt: *stmts) {
+                report.strings += detail::heap_bytes(stmt.name);
+                if (const auto* sub = std::get_if<std::vector<detail::stmt_v>>(&stmt.val)) {
+                    pending.push_back(sub);
+                } else {
+                    std::visit([&report](const auto& v) {
+                        if constexpr (!std::is_same_v<std::decay_t<decltype(v)>, std::vector<detail::stmt_v>>) {
+                            detail::account(report, v);
+                        }
+                    }, stmt.val);
+                }
+            }
+        }
+        return report;
+    }
+
+    memory_report memory_usage(const dot_graph_resolved& graph) {
+        memory_report report;
+        report.containers += sizeof(graph);
+        std::vector<const dot_graph_resolved*> pending {&graph};
+        while (!pending.empty()) {
+            const auto* g = pending.back();
+            pending.pop_back();
+            report.strings += detail::heap_bytes(g->graph_type) + detail::heap_bytes(g->name);
+            detail::account(report, g->graph_attrs);
+            report.containers += detail::heap_bytes(g->statements);
+            for (const auto& stmt: g->statements) {
+                if (const auto* sub = std::get_if<dot_graph_resolved>(&stmt)) {
+                    pending.push_back(sub);  // its sizeof is part of the statement vector already
+                } else if (const auto* v = std::get_if<detail::node_stmt_v>(&stmt)) {
+                    detail::account(report, *v);
+                } else {
+                    detail::account(report, std::get<detail::edge_stmt_v>(stmt));
+                }
+            }
+        }
+        return report;
+    }
+
+    memory_report memory_usage(const dot_graph_flat& graph) {
+        memory_report report;
+        report.containers += sizeof(graph) + detail::heap_bytes(graph.statements);
+        report.strings += detail::heap_bytes(graph.graph_type);
+        for (const auto& stmt: graph.statements) {
+            std::visit([&report](const auto& v) { detail::account(report, v); }, stmt);
+        }
+        return report;
+    }
+
+    std::size_t compact(dot_graph_raw& graph) {
+        auto before = memory_usage(graph).total();
+        graph.graph_type.shrink_to_fit();
+        graph.name.shrink_to_fit();
+        std::vector<std::vector<detail::stmt_v>*> pending {&graph.statements};
+        while (!pending.empty()) {
+            auto* stmts = pending.back();
+            pending.pop_back();
+            stmts->shrink_to_fit();
+            for (auto& stmt: *stmts) {
+                stmt.name.shrink_to_fit();
+                if (auto* sub = std::get_if<std::vector<detail::stmt_v>>(&stmt.val)) {
+                    pending.push_back(sub);
+                } else {
+                    std::visit([](auto& v) {
+                        if constexpr (!std::is_same_v<std::decay_t<decltype(v)>, std::vector<detail::stmt_v>>) {
+                            detail::shrink(v);
+                        }
+                    }, stmt.val);
+                }
+            }
+        }
+        return before-memory_usage(graph).total();
+    }
+
+    std::size_t compact(dot_graph_resolved& graph) {
+        auto before = memory_usage(graph).total();
+        std::vector<dot_graph_resolved*> pending {&graph};
+        while (!pending.empty()) {
+            auto* g = pending.back();
+            pending.pop_back();
+            g->graph_type.shrink_to_fit();
+            g->name.shrink_to_fit();
+            g->statements.shrink_to_fit();  // graph_attrs is a std::map; nothing to trim
+            for (auto& stmt: g->statements) {
+                if (auto* sub = std::get_if<dot_graph_resolved>(&stmt)) {
+                    pending.push_back(sub);
+                } else if (auto* v = std::get_if<detail::node_stmt_v>(&stmt)) {
+                    detail::shrink(*v);
+                } else {
+                    detail::shrink(std::get<detail::edge_stmt_v>(stmt));
+                }
+            }
+        }
+        return before-memory_usage(graph).total();
+    }
+
+    std::size_t compact(dot_graph_flat& graph) {
+        auto before = memory_usage(graph).total();
+        graph.graph_type.shrink_to_fit();
+        graph.statements.shrink_to_fit();
+        for (auto& stmt: graph.statements) {
+            std::visit([](auto& v) { detail::shrink(v); }, stmt);
+        }
+        return before-memory_usage(graph).total();
+    }
+
+    namespace detail {
+        // assigns ids to distinct strings of the graph being packed; views point into that graph
+        struct string_interner {
+            flat_hash_map<std::string_view, packed_graph::string_id> ids;
+            std::vector<std::string_view> strings;
+            std::size_t chars{};
+
+            explicit string_interner(std::size_t expected): ids{expected} {}
+            packed_graph::string_id operator()(const std::string& s) {
+                auto [id, inserted] = ids.try_emplace(s, static_cast<packed_graph::string_id>(strings.size()));
+                if (inserted) {
+                    strings.emplace_back(s);
+                    chars += s.size();
+                }
+                return *id;
+            }
+        };
+
+        template<typename T>
+        std::uint32_t checked_id(const std::vector<T>& v) {
+            if (v.size()>=std::numeric_limits<std::uint32_t>::max()) {
+                throw std::runtime_error("graph too large to pack with 32-bit ids");
+            }
+            return static_cast<std::uint32_t>(v.size());
+        }
+    }
+
+    packed_graph pack(const dot_graph_flat& graph) {
+        std::size_t edge_count = 0;
+        std::size_t attr_count = 0;
+        for (const auto& stmt: graph.statements) {
+            if (const auto* v = std::get_if<detail::edge_stmt_v>(&stmt)) {
+                edge_count += v->edges.size();
+                attr_count += v->attrs.size();
+            } else {
+                attr_count += std::get<detail::node_stmt_v>(stmt).attrs.size();
+            }
+        }
+        packed_graph packed;
+        packed.is_strict = graph.is_strict;
+        packed.statements.reserve(graph.statements.size());
+        packed.edges.reserve(edge_count);
+        packed.attrs.reserve(attr_count);
+
+        detail::string_interner intern{graph.statements.size()+attr_count};
+        packed.graph_type = intern(graph.graph_type);
+        auto add_attrs = [&](packed_graph::statement& stmt, const detail::attr_list_type& attrs) {
+            stmt.first_attr = detail::checked_id(packed.attrs);
+            stmt.attr_count = static_cast<std::uint32_t>(attrs.size());
+            for (const auto& [key, value]: attrs) {
+                packed.attrs.push_back(packed_graph::attr{intern(key), intern(value)});
+            }
+        };
+        for (const auto& stmt: graph.statements) {
+            packed_graph::statement packed_stmt{};
+            if (const auto* v = std::get_if<detail::edge_stmt_v>(&stmt)) {
+                packed_stmt.is_edge = true;
+                packed_stmt.first_edge = detail::checked_id(packed.edges);
+                packed_stmt.edge_count = static_cast<std::uint32_t>(v->edges.size());
+                for (const auto& e: v->edges) {
+                    packed.edges.push_back(packed_graph::packed_edge{intern(e.src), intern(e.edge_op), intern(e.tgt)});
+                }
+                add_attrs(packed_stmt, v->attrs);
+            } else {
+                const auto& node = std::get<detail::node_stmt_v>(stmt);
+                packed_stmt.node_name = intern(node.node_name);
+                add_attrs(packed_stmt, node.attrs);
+            }
+            packed.statements.push_back(packed_stmt);
+        }
+        detail::checked_id(packed.attrs);
+        detail::checked_id(packed.edges);
+        detail::checked_id(intern.strings);
+        if (intern.chars>=std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("graph too large to pack with 32-bit ids");
+        }
+
+        packed.chars.reserve(intern.chars);
+        packed.offsets.reserve(intern.strings.size()+1);
+        for (auto s: intern.strings) {
+            packed.chars += s;
+            packed.offsets.push_back(static_cast<std::uint32_t>(packed.chars.size()));
+        }
+        return packed;
+    }
+
+    dot_graph_flat packed_graph::unpack() const {
+        dot_graph_flat graph{ .is_strict=is_strict, .graph_type=std::string{str(graph_type)} };
+        graph.statements.reserve(statements.size());
+        auto unpack_attrs = [this](const statement& stmt) {
+            detail::attr_list_type list;
+            list.reserve(stmt.attr_count);
+            for (auto i = stmt.first_attr; i < stmt.first_attr+stmt.attr_count; ++i) {
+                list.emplace_back(str(attrs[i].key), str(attrs[i].value));
+            }
+            return list;
+        };
+        for (const auto& stmt: statements) {
+            if (stmt.is_edge) {
+                detail::edge_stmt_v v;
+                v.edges.reserve(stmt.edge_count);
+                for (auto i = stmt.first_edge; i < stmt.first_edge+stmt.edge_count; ++i) {
+                    v.edges.push_back(edge{ std::string{str(edges[i].src)}, std::string{str(edges[i].edge_op)},
+                                            std::string{str(edges[i].tgt)} });
+                }
+                v.attrs = unpack_attrs(stmt);
+                graph.statements.emplace_back(std::move(v));
+            } else {
+                graph.statements.emplace_back(detail::node_stmt_v{ .node_name=std::string{str(stmt.node_name)}, .attrs=unpack_attrs(stmt) });
+            }
+        }
+        return graph;
+    }
+
+    memory_report memory_usage(const packed_graph& graph) {
+        memory_report report;
+        report.strings += detail::heap_bytes(graph.chars) + detail::heap_bytes(graph.offsets);
+        report.attr_lists += detail::heap_bytes(graph.attrs);
+        report.edges += detail::heap_bytes(graph.edges);
+        report.containers += sizeof(graph) + detail::heap_bytes(graph.statements);
+        return report;
+    }
+}
@@ -48,4 +48,112 @@ namespace dot_parser::detail {
             val = std::get<attr_item_v>(v);
         }
     }
+
+    // copies level by level; every stmt_v copied in here is a leaf statement or gets an empty subgraph
+    void copy_nested(const std::vector<stmt_v>& from, std::vector<stmt_v>& to) {
+        std::vector<std::pair<const std::vector<stmt_v>*, std::vector<stmt_v>*>> pending {{&from, &to}};
+        while (!pending.empty()) {
+            auto [src, dst] = pending.back();
+            pending.pop_back();
+            dst->reserve(src->size());  // nested lists queued below must not move
+            for (const auto& stmt: *src) {
+                const auto* sub = std::get_if<std::vector<stmt_v>>(&stmt.val);
+                if (sub==nullptr) {
+                    dst->push_back(stmt);
+                } else {
+                    dst->emplace_back(stmt.name, std::vector<stmt_v>{});
+                    pending.emplace_back(sub, &std::get<std::vector<stmt_v>>(dst->back().val));
+                }
+            }
+        }
+    }
+
+    stmt_v::stmt_v(const stmt_v& other): name{other.name} {
+        if (const auto* sub = std::get_if<std::vector<stmt_v>>(&other.val)) {
+            val = std::vector<stmt_v>{};
+            copy_nested(*sub, std::get<std::vector<stmt_v>>(val));
+        } else {
+            val = other.val;
+        }
+    }
+
+    stmt_v& stmt_v::operator=(const stmt_v& other) {
+        if (this!=&other) {
+            *this = stmt_v{other};
+        }
+        return *this;
+    }
+
+    stmt_v::~stmt_v() {
+        // move nested statement lists onto an explicit stack, so that each stmt_v dies with an empty subgraph
+        auto* sub = std::get_if<std::vector<stmt_v>>(&val);
+        if (sub==nullptr || sub->empty()) {
+            return;
+        }
+        std::vector<std::vector<stmt_v>> pending;
+        pending.push_back(std::move(*sub));
+        while (!pending.empty()) {
+            auto stmts = std::move(pending.back());
+            pending.pop_back();
+            for (auto& stmt: stmts) {
+                auto* nested = std::get_if<std::vector<stmt_v>>(&stmt.val);
+                if (nested!=nullptr && !nested->empty()) {
+                    pending.push_back(std::move(*nested));
+                }
+            }
+        }
+    }
+
+    resolved_stmt_list::resolved_stmt_list(std::vector<resolved_stmt_type> v) noexcept: std::vector<resolved_stmt_type>{std::move(v)} {}
+    resolved_stmt_list::resolved_stmt_list(resolved_stmt_list&& other) noexcept = default;
+    resolved_stmt_list& resolved_stmt_list::operator=(resolved_stmt_list&& other) noexcept = default;
+
+    // same tricks as for stmt_v, one subgraph level per step
+    resolved_stmt_list::resolved_stmt_list(const resolved_stmt_list& other): std::vector<resolved_stmt_type>{} {
+        std::vector<std::pair<const resolved_stmt_list*, resolved_stmt_list*>> pending {{&other, this}};
+        while (!pending.empty()) {
+            auto [src, dst] = pending.back();
+            pending.pop_back();
+            dst->reserve(src->size());
+            for (const auto& stmt: *src) {
+                const auto* sub = std::get_if<dot_graph_resolved>(&stmt);
+                if (sub==nullptr) {
+                    dst->push_back(stmt);
+                } else {  // everything but the statements, which are queued
+                    dst->emplace_back(dot_graph_resolved{ .is_strict=sub->is_strict,
+                                                          .graph_type=sub->graph_type,
+                                                          .name=sub->name,
+                                                          .graph_attrs=sub->graph_attrs,
+                                                          .hash=sub->hash,
+                                                          .stats=sub->stats });
+                    pending.emplace_back(&sub->statements, &std::get<dot_graph_resolved>(dst->back()).statements);
+                }
+            }
+        }
+    }
+
+    resolved_stmt_list& resolved_stmt_list::operator=(const resolved_stmt_list& other) {
+        if (this!=&other) {
+            *this = resolved_stmt_list{other};
+        }
+        return *this;
+    }
+
+    resolved_stmt_list::~resolved_stmt_list() {
+        std::vector<std::vector<resolved_stmt_type>> pending;
+        auto hollow = [&pending](std::vector<resolved_stmt_type>& stmts) {
+            for (auto& stmt: stmts) {
+                auto* sub = std::get_if<dot_graph_resolved>(&stmt);
+                if (sub!=nullptr && !sub->statements.empty()) {
+                    pending.push_back(std::move(sub->statements));
+                }
+            }
+        };
+        hollow(*this);
+        while (!pending.empty()) {
+            auto stmts = std::move(pending.back());
+            pending.pop_back();
+            hollow(stmts);
+        }
+    }
 }
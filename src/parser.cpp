@@ -1,4 +1,5 @@
 #include "parser.hpp"
+#include "detail/grammar.hpp"
 #include <lexy/input/string_input.hpp>
 #include <lexy/input/file.hpp>
 #include <lexy/action/parse.hpp> // lexy::parse
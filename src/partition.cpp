@@ -0,0 +1,504 @@
+#include "partition.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <functional>
+#include <ostream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+
+namespace dot_parser {
+    namespace detail {
+        // calls v.node, v.edges, v.open (descends if it returns true) and v.close in document order
+        template<typename Visitor>
+        void walk(const dot_graph_resolved& graph, Visitor& v) {
+            // (graph, index of next statement); explicit stack in place of recursion
+            std::vector<std::pair<const dot_graph_resolved*, std::size_t>> stack;
+            stack.emplace_back(&graph, 0);
+            while (!stack.empty()) {
+                auto& [g, next] = stack.back();
+                if (next==g->statements.size()) {
+                    stack.pop_back();
+                    if (!stack.empty()) {
+                        v.close();
+                    }
+                    continue;
+                }
+                const auto& stmt = g->statements[next++];
+                if (std::holds_alternative<node_stmt_v>(stmt)) {
+                    v.node(std::get<node_stmt_v>(stmt));
+                } else if (std::holds_alternative<edge_stmt_v>(stmt)) {
+                    v.edges(std::get<edge_stmt_v>(stmt));
+                } else {
+                    assert(std::holds_alternative<dot_graph_resolved>(stmt));
+                    const auto& sub = std::get<dot_graph_resolved>(stmt);
+                    if (v.open(sub)) {
+                        stack.emplace_back(&sub, 0);  // invalidates g and next
+                    }
+                }
+            }
+        }
+        template<typename Visitor>
+        void walk(const dot_graph_flat& graph, Visitor& v) {
+            for (const auto& stmt: graph.statements) {
+                if (std::holds_alternative<node_stmt_v>(stmt)) {
+                    v.node(std::get<node_stmt_v>(stmt));
+                } else {
+                    v.edges(std::get<edge_stmt_v>(stmt));
+                }
+            }
+        }
+
+        struct subgraph_info {
+            std::size_t weight{};  // nodes + edges in the whole subtree
+            std::size_t statements{};  // node/edge statements in the whole subtree
+            std::size_t subgraphs{};  // nested ones, in the whole subtree
+        };
+
+        // first pass: sizes of all subgraphs, numbered in document order
+        struct measure {
+            std::vector<subgraph_info> subgraphs;
+            std::vector<std::size_t> enclosing;
+            std::size_t statements{};
+            std::size_t nodes{};
+            std::size_t total{};
+
+            void leaf(std::size_t weight) {
+                ++statements;
+                total += weight;
+                if (!enclosing.empty()) {
+                    subgraphs[enclosing.back()].weight += weight;
+                }
+            }
+            void node(const node_stmt_v&) { ++nodes; leaf(1); }
+            void edges(const edge_stmt_v& v) { leaf(v.edges.size()); }
+            bool open(const dot_graph_resolved&) {
+                enclosing.push_back(subgraphs.size());
+                // start values for now; turned into counts on close
+                subgraphs.push_back(subgraph_info{ .statements=statements, .subgraphs=subgraphs.size() });
+                return true;
+            }
+            void close() {
+                auto i = enclosing.back();
+                enclosing.pop_back();
+                auto& info = subgraphs[i];
+                info.statements = statements-info.statements;
+                info.subgraphs = subgraphs.size()-info.subgraphs-1;
+                if (!enclosing.empty()) {
+                    subgraphs[enclosing.back()].weight += info.weight;
+                }
+            }
+        };
+
+        // a run of statements placed together: a single statement or a whole subgraph
+        struct unit {
+            std::size_t first;
+            std::size_t count;
+            std::size_t weight;
+            bool whole_subgraph;
+        };
+
+        // second pass: keep subgraphs up to target whole, split heavier ones
+        struct collect_units {
+            const std::vector<subgraph_info>& subgraphs;
+            std::size_t target;
+            std::vector<unit> units;
+            std::size_t statements{};
+            std::size_t next_subgraph{};
+
+            void node(const node_stmt_v&) {
+                units.push_back(unit{ .first=statements++, .count=1, .weight=1, .whole_subgraph=false });
+            }
+            void edges(const edge_stmt_v& v) {
+                units.push_back(unit{ .first=statements++, .count=1, .weight=v.edges.size(), .whole_subgraph=false });
+            }
+            bool open(const dot_graph_resolved&) {
+                const auto& info = subgraphs[next_subgraph++];
+                if (info.weight>target) {
+                    return true;
+                }
+                units.push_back(unit{ .first=statements, .count=info.statements, .weight=info.weight, .whole_subgraph=true });
+                statements += info.statements;
+                next_subgraph += info.subgraphs;
+                return false;
+            }
+            void close() {}
+        };
+
+        struct partition_builder {
+            // third pass: node owners, loads and cut edges
+            struct place {
+                graph_partition& parts;
+                std::size_t statement{};
+
+                void node(const node_stmt_v& v) {
+                    auto shard = parts.stmt_shards[statement++];
+                    auto id = static_cast<std::uint64_t>(parts.node_entries.size());
+                    if (!parts.node_entries.try_emplace(v.node_name, graph_partition::node_entry{ .id=id, .shard=shard }).second) {
+                        throw std::runtime_error("redefining node: " + v.node_name);
+                    }
+                    ++parts.shard_loads[shard].nodes;
+                }
+                void edges(const edge_stmt_v& v) {
+                    auto shard = parts.stmt_shards[statement++];
+                    parts.shard_loads[shard].edges += v.edges.size();
+                    for (const auto& e: v.edges) {
+                        const auto* src = parts.node_entries.find(e.src);
+                        const auto* tgt = parts.node_entries.find(e.tgt);
+                        if (src==nullptr || tgt==nullptr) {
+                            throw std::runtime_error("edge " + e.to_string() + " contains undefined node(s)");
+                        }
+                        if (src->shard!=shard || tgt->shard!=shard) {
+                            parts.cuts.push_back(cut_edge{ .e=&e, .shard=shard, .src_shard=src->shard, .tgt_shard=tgt->shard });
+                        }
+                    }
+                }
+                bool open(const dot_graph_resolved&) { return true; }
+                void close() {}
+            };
+
+            template<typename Graph>
+            static graph_partition build(const Graph& graph, std::size_t shards) {
+                if (shards==0) {
+                    throw std::runtime_error("cannot partition into 0 shards");
+                }
+                measure sizes;
+                walk(graph, sizes);
+                auto target = std::max<std::size_t>((sizes.total+shards-1)/shards, 1);
+                collect_units collected{ .subgraphs=sizes.subgraphs, .target=target };
+                walk(graph, collected);
+                const auto& units = collected.units;
+
+                // whole subgraphs first, largest first onto the lightest shard (LPT)
+                std::vector<std::size_t> weights(shards, 0);
+                std::vector<std::uint32_t> unit_shards(units.size(), 0);
+                std::vector<std::size_t> kept;
+                for (std::size_t i = 0; i < units.size(); ++i) {
+                    if (units[i].whole_subgraph) {
+                        kept.push_back(i);
+                    }
+                }
+                std::stable_sort(kept.begin(), kept.end(), [&units](std::size_t a, std::size_t b) {
+                    return units[a].weight>units[b].weight;
+                });
+                using entry = std::pair<std::size_t, std::size_t>;  // (weight, shard)
+                std::priority_queue<entry, std::vector<entry>, std::greater<>> lightest;
+                for (std::size_t s = 0; s < shards; ++s) {
+                    lightest.emplace(0, s);
+                }
+                for (auto i: kept) {
+                    auto [weight, s] = lightest.top();
+                    lightest.pop();
+                    unit_shards[i] = static_cast<std::uint32_t>(s);
+                    weights[s] = weight+units[i].weight;
+                    lightest.emplace(weights[s], s);
+                }
+                // then loose statements in document order, moving on whenever a shard has its share
+                std::size_t cursor = 0;
+                for (std::size_t i = 0; i < units.size(); ++i) {
+                    if (units[i].whole_subgraph) {
+                        continue;
+                    }
+                    while (cursor+1<shards && weights[cursor]>=target) {
+                        ++cursor;
+                    }
+                    unit_shards[i] = static_cast<std::uint32_t>(cursor);
+                    weights[cursor] += units[i].weight;
+                }
+
+                graph_partition parts;
+                parts.shard_loads.resize(shards);
+                parts.stmt_shards.resize(sizes.statements);
+                for (std::size_t i = 0; i < units.size(); ++i) {
+                    std::fill_n(parts.stmt_shards.begin()+static_cast<std::ptrdiff_t>(units[i].first), units[i].count, unit_shards[i]);
+                }
+                parts.node_entries.reserve(sizes.nodes);
+                place placed{ .parts=parts };
+                walk(graph, placed);
+                return parts;
+            }
+        };
+
+        bool is_plain_id(const std::string& id) {
+            static constexpr const char* keywords[] = { "graph", "digraph", "subgraph", "node", "edge", "strict" };
+            if (id.empty()) {
+                return false;
+            }
+            for (auto c: id) {
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c!='_') {
+                    return false;
+                }
+            }
+            return std::none_of(std::begin(keywords), std::end(keywords), [&id](const char* k) {
+                return std::equal(id.begin(), id.end(), k, k+std::char_traits<char>::length(k), [](char a, char b) {
+                    return std::tolower(static_cast<unsigned char>(a))==b;
+                });
+            });
+        }
+        // quoted unless it is a plain identifier, so that the output parses back to the same names
+        void write_id(std::ostream& os, const std::string& id) {
+            if (is_plain_id(id)) {
+                os << id;
+                return;
+            }
+            os << '"';
+            for (auto c: id) {
+                switch (c) {
+                    case '"': os << "\\\""; break;
+                    case '\\': os << "\\\\"; break;
+                    case '\b': os << "\\b"; break;
+                    case '\f': os << "\\f"; break;
+                    case '\n': os << "\\n"; break;
+                    case '\r': os << "\\r"; break;
+                    case '\t': os << "\\t"; break;
+                    default: os << c;
+                }
+            }
+            os << '"';
+        }
+        void write_indent(std::ostream& os, std::size_t depth) {
+            for (std::size_t i = 0; i < depth; ++i) {
+                os << "    ";
+            }
+        }
+        void write_attrs(std::ostream& os, const attr_list_type& attrs) {
+            if (attrs.empty()) {
+                return;
+            }
+            os << " [";
+            for (std::size_t i = 0; i < attrs.size(); ++i) {
+                if (i>0) {
+                    os << ", ";
+                }
+                write_id(os, attrs[i].first);
+                os << '=';
+                write_id(os, attrs[i].second);
+            }
+            os << ']';
+        }
+        void write_graph_attrs(std::ostream& os, const std::map<std::string, std::string>& attrs, std::size_t depth) {
+            for (const auto& [key, value]: attrs) {
+                write_indent(os, depth);
+                write_id(os, key);
+                os << '=';
+                write_id(os, value);
+                os << '\n';
+            }
+        }
+
+        void check_outputs(const graph_partition& parts, const std::vector<std::ostream*>& out) {
+            if (out.size()!=parts.shard_count()) {
+                throw std::runtime_error("expected " + std::to_string(parts.shard_count()) + " outputs, got " + std::to_string(out.size()));
+            }
+        }
+        std::uint32_t next_shard(const graph_partition& parts, std::size_t& statement) {
+            if (statement>=parts.statement_shards().size()) {
+                throw std::runtime_error("partition does not match the graph");
+            }
+            return parts.statement_shards()[statement++];
+        }
+
+        struct dot_writer {
+            const graph_partition& parts;
+            const std::vector<std::ostream*>& out;
+            std::vector<const dot_graph_resolved*> enclosing;
+            std::vector<std::vector<std::size_t>> opened_by;  // per enclosing subgraph: shards whose output entered it
+            std::vector<std::size_t> opened;  // per shard: how many enclosing subgraphs its output has entered
+            std::size_t statement{};
+
+            // enters the enclosing subgraphs in the shard's output; null if the shard is skipped
+            std::ostream* enter(std::uint32_t shard) {
+                auto* os = out[shard];
+                if (os==nullptr) {
+                    return nullptr;
+                }
+                for (auto& depth = opened[shard]; depth<enclosing.size(); ++depth) {
+                    const auto& sub = *enclosing[depth];
+                    write_indent(*os, depth+1);
+                    *os << "subgraph ";
+                    if (!sub.name.empty()) {
+                        write_id(*os, sub.name);
+                        *os << ' ';
+                    }
+                    *os << "{\n";
+                    write_graph_attrs(*os, sub.graph_attrs, depth+2);
+                    opened_by[depth].push_back(shard);
+                }
+                write_indent(*os, enclosing.size()+1);
+                return os;
+            }
+            void node(const node_stmt_v& v) {
+                if (auto* os = enter(next_shard(parts, statement))) {
+                    write_id(*os, v.node_name);
+                    write_attrs(*os, v.attrs);
+                    *os << '\n';
+                }
+            }
+            void edges(const edge_stmt_v& v) {
+                auto shard = next_shard(parts, statement);
+                for (std::size_t i = 0; i < v.edges.size(); ++i) {
+                    if (auto* os = enter(shard)) {
+                        write_id(*os, v.edges[i].src);
+                        *os << ' ' << v.edges[i].edge_op << ' ';
+                        write_id(*os, v.edges[i].tgt);
+                        write_attrs(*os, v.attrs);
+                        *os << '\n';
+                    }
+                }
+            }
+            bool open(const dot_graph_resolved& sub) {
+                enclosing.push_back(&sub);
+                opened_by.emplace_back();
+                return true;
+            }
+            void close() {
+                auto depth = enclosing.size()-1;
+                for (auto shard: opened_by.back()) {
+                    write_indent(*out[shard], depth+1);
+                    *out[shard] << "}\n";
+                    opened[shard] = depth;
+                }
+                enclosing.pop_back();
+                opened_by.pop_back();
+            }
+        };
+
+        template<typename Graph>
+        void write_dot_impl(const Graph& graph, const std::string& name, const std::map<std::string, std::string>& graph_attrs,
+                            const graph_partition& parts, const std::vector<std::ostream*>& out) {
+            check_outputs(parts, out);
+            // foreign ends of cut edges are declared up front so that every shard resolves on its own
+            std::vector<flat_hash_set<std::string_view>> seen(out.size());
+            std::vector<std::vector<const std::string*>> ghosts(out.size());
+            auto add_ghost = [&seen, &ghosts](std::size_t shard, const std::string& node) {
+                if (seen[shard].insert(node)) {
+                    ghosts[shard].push_back(&node);
+                }
+            };
+            for (const auto& cut: parts.cut_edges()) {
+                if (out[cut.shard]!=nullptr) {
+                    if (cut.src_shard!=cut.shard) {
+                        add_ghost(cut.shard, cut.e->src);
+                    }
+                    if (cut.tgt_shard!=cut.shard) {
+                        add_ghost(cut.shard, cut.e->tgt);
+                    }
+                }
+            }
+            for (std::size_t s = 0; s < out.size(); ++s) {
+                if (out[s]==nullptr) {
+                    continue;
+                }
+                auto& os = *out[s];
+                os << (graph.is_strict ? "strict " : "") << graph.graph_type << ' ';
+                if (!name.empty()) {
+                    write_id(os, name);
+                    os << ' ';
+                }
+                os << "{\n";
+                write_graph_attrs(os, graph_attrs, 1);
+                for (const auto* node: ghosts[s]) {
+                    write_indent(os, 1);
+                    write_id(os, *node);
+                    os << '\n';
+                }
+            }
+            dot_writer writer{ .parts=parts, .out=out, .opened=std::vector<std::size_t>(out.size(), 0) };
+            walk(graph, writer);
+            if (writer.statement!=parts.statement_shards().size()) {
+                throw std::runtime_error("partition does not match the graph");
+            }
+            for (auto* os: out) {
+                if (os!=nullptr) {
+                    *os << "}\n";
+                }
+            }
+        }
+
+        struct edge_list_writer {
+            static constexpr std::size_t flush_bytes = 1<<13;
+            const graph_partition& parts;
+            const std::vector<std::ostream*>& out;
+            std::vector<std::string> buffers;
+            std::size_t statement{};
+
+            static void put(std::string& buffer, std::uint64_t v) {
+                for (int i = 0; i < 8; ++i) {
+                    buffer.push_back(static_cast<char>((v >> (8*i)) & 0xff));
+                }
+            }
+            void flush(std::size_t shard) {
+                out[shard]->write(buffers[shard].data(), static_cast<std::streamsize>(buffers[shard].size()));
+                buffers[shard].clear();
+            }
+            void node(const node_stmt_v&) { next_shard(parts, statement); }
+            void edges(const edge_stmt_v& v) {
+                auto shard = next_shard(parts, statement);
+                if (out[shard]==nullptr) {
+                    return;
+                }
+                auto& buffer = buffers[shard];
+                for (const auto& e: v.edges) {
+                    put(buffer, parts.node_id(e.src));
+                    put(buffer, parts.node_id(e.tgt));
+                    if (buffer.size()>=flush_bytes) {
+                        flush(shard);
+                    }
+                }
+            }
+            bool open(const dot_graph_resolved&) { return true; }
+            void close() {}
+        };
+
+        template<typename Graph>
+        void write_edge_list_impl(const Graph& graph, const graph_partition& parts, const std::vector<std::ostream*>& out) {
+            check_outputs(parts, out);
+            edge_list_writer writer{ .parts=parts, .out=out, .buffers=std::vector<std::string>(out.size()) };
+            walk(graph, writer);
+            if (writer.statement!=parts.statement_shards().size()) {
+                throw std::runtime_error("partition does not match the graph");
+            }
+            for (std::size_t s = 0; s < out.size(); ++s) {
+                if (out[s]!=nullptr) {
+                    writer.flush(s);
+                }
+            }
+        }
+    }
+
+    std::size_t graph_partition::node_shard(std::string_view node) const {
+        const auto* entry = node_entries.find(node);
+        if (entry==nullptr) {
+            throw std::runtime_error("unknown node: " + std::string(node));
+        }
+        return entry->shard;
+    }
+    std::uint64_t graph_partition::node_id(std::string_view node) const {
+        const auto* entry = node_entries.find(node);
+        if (entry==nullptr) {
+            throw std::runtime_error("unknown node: " + std::string(node));
+        }
+        return entry->id;
+    }
+
+    graph_partition partition(const dot_graph_resolved& graph, std::size_t shards) {
+        return detail::partition_builder::build(graph, shards);
+    }
+    graph_partition partition(const dot_graph_flat& graph, std::size_t shards) {
+        return detail::partition_builder::build(graph, shards);
+    }
+
+    void write_dot(const dot_graph_resolved& graph, const graph_partition& parts, const std::vector<std::ostream*>& out) {
+        detail::write_dot_impl(graph, graph.name, graph.graph_attrs, parts, out);
+    }
+    void write_dot(const dot_graph_flat& graph, const graph_partition& parts, const std::vector<std::ostream*>& out) {
+        detail::write_dot_impl(graph, "", {}, parts, out);
+    }
+    void write_edge_list(const dot_graph_resolved& graph, const graph_partition& parts, const std::vector<std::ostream*>& out) {
+        detail::write_edge_list_impl(graph, parts, out);
+    }
+    void write_edge_list(const dot_graph_flat& graph, const graph_partition& parts, const std::vector<std::ostream*>& out) {
+        detail::write_edge_list_impl(graph, parts, out);
+    }
+}
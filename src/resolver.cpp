@@ -1,31 +1,229 @@
 #include "resolver.hpp"
+#include "diff.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <exception>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 
 namespace dot_parser {
     namespace detail {
-        dot_graph_resolved resolve_impl(const dot_graph_raw& raw_graph,
-                                        external_attrs ext_attrs,
-                                        std::unordered_set<std::string>& nodes_seen,
-                                        std::unordered_set<edge>& edges_seen) {
-            dot_graph_resolved resolved { .is_strict=raw_graph.is_strict,
-                                          .graph_type=raw_graph.graph_type,  // "graph" or "digraph"
-                                          .name=raw_graph.name, .graph_attrs=ext_attrs.graph };
+        std::optional<std::string> edge_op_error(const dot_graph_raw& raw_graph, const edge& e) {
+            if (raw_graph.graph_type=="graph" && e.edge_op=="->") {
+                return "directed edge (" + e.to_string() + ") in an undirected graph";
+            } else if (raw_graph.graph_type=="digraph" && e.edge_op=="--") {
+                return "undirected edge (" + e.to_string() + ") in a directed graph";
+            }
+            return std::nullopt;
+        }
+
+        // node/edge checks of the sequential resolve: everything is checked on the spot
+        struct sequential_checks {
+            const dot_graph_raw& raw_graph;
+            node_set& nodes_seen;
+            edge_set& edges_seen;
+
+            void node(const node_stmt_v& v) {
+                if (!nodes_seen.insert(v.node_name)) {
+                    throw std::runtime_error("redefining node: " + v.node_name);
+                }
+            }
+            void edges(const edge_stmt_v& v) {
+                for (const auto& e: v.edges) {
+                    // undefined node(s)
+                    if (!nodes_seen.contains(e.src) || !nodes_seen.contains(e.tgt)) {
+                        throw std::runtime_error("edge " + e.to_string() + " contains undefined node(s)");
+                    }
+                    // conflicting edge op
+                    if (auto error = edge_op_error(raw_graph, e)) {
+                        throw std::runtime_error(*error);
+                    }
+                    // multi-edge
+                    if (raw_graph.is_strict) {  // disallow multi-edge
+                        if (!edges_seen.insert(&e)) {
+                            throw std::runtime_error("duplicate edges for a strict graph: " + e.to_string());
+                        }
+                    }
+                }
+            }
+        };
+
+        // strict-graph edges seen by the parallel resolve, sharded to keep lock contention down
+        // remembers the first two occurrences of each edge so that the earliest duplicate can be reported
+        class edge_registry {
+        public:
+            void add(const edge& e, std::uint64_t position) {
+                auto& s = shards[std::hash<edge>{}(e) % shards.size()];
+                std::lock_guard<std::mutex> lock{s.mutex};
+                auto [it, inserted] = s.edges.try_emplace(e, occurrences{position, e});
+                if (inserted) {
+                    return;
+                }
+                auto& o = it->second;
+                if (position<o.first) {
+                    o.second = o.first;
+                    o.second_edge = o.first_edge;
+                    o.first = position;
+                    o.first_edge = e;
+                } else if (position<o.second) {
+                    o.second = position;
+                    o.second_edge = e;
+                }
+            }
+            // error of the sequential resolve, if any
+            [[nodiscard]] std::optional<std::string> first_duplicate() const {
+                const occurrences* earliest = nullptr;
+                for (const auto& s: shards) {
+                    for (const auto& [e, o]: s.edges) {
+                        if (o.second!=none && (earliest==nullptr || o.second<earliest->second)) {
+                            earliest = &o;
+                        }
+                    }
+                }
+                if (earliest==nullptr) {
+                    return std::nullopt;
+                }
+                return "duplicate edges for a strict graph: " + earliest->second_edge.to_string();
+            }
+        private:
+            static constexpr auto none = std::numeric_limits<std::uint64_t>::max();
+            struct occurrences {
+                std::uint64_t first;
+                edge first_edge;
+                std::uint64_t second = none;
+                edge second_edge;
+            };
+            struct shard {
+                std::mutex mutex;
+                std::unordered_map<edge, occurrences> edges;
+            };
+            std::array<shard, 64> shards;
+        };
+
+        // node/edge checks of the parallel resolve; the declaration pass has checked all but duplicate edges
+        // positions count node statements and single edges in declaration order, same as in the declaration pass
+        struct deferred_checks {
+            edge_registry* strict_edges;  // nullptr unless the graph is strict
+            std::uint64_t position;
+
+            void node(const node_stmt_v&) {
+                ++position;
+            }
+            void edges(const edge_stmt_v& v) {
+                for (const auto& e: v.edges) {
+                    if (strict_edges) {
+                        strict_edges->add(e, position);
+                    }
+                    ++position;
+                }
+            }
+        };
+
+        // own attributes win over inherited ones, and the first of repeated keys wins, as with a std::map built from them
+        // sorts and merges within the result vector, which is the only allocation unless own is long and unsorted
+        attr_list_type merge_attrs(const attr_list_type& own, const external_attrs::a_table& inherited) {
+            auto key_less = [](const attr_item_v& a, const attr_item_v& b) { return a.first<b.first; };
+            auto key_greater_eq = [](const attr_item_v& a, const attr_item_v& b) { return !(a.first<b.first); };
+            attr_list_type merged;
+            merged.reserve(own.size()+inherited.size());
+            merged.assign(own.begin(), own.end());
+            if (std::adjacent_find(merged.begin(), merged.end(), key_greater_eq)!=merged.end()) {  // not strictly sorted
+                // both stable, to keep the first of repeated keys in front
+                if (merged.size()<=16) {
+                    for (auto it = merged.begin()+1; it!=merged.end(); ++it) {
+                        std::rotate(std::upper_bound(merged.begin(), it, *it, key_less), it, it+1);
+                    }
+                } else {
+                    std::stable_sort(merged.begin(), merged.end(), key_less);
+                }
+                merged.erase(std::unique(merged.begin(), merged.end(),
+                                         [](const attr_item_v& a, const attr_item_v& b) { return a.first==b.first; }),
+                             merged.end());
+            }
+
+            // inherited keys that aren't overridden go in between, merging from the back
+            auto own_end = merged.size();
+            std::size_t added = 0;
+            auto it = merged.begin();
+            for (const auto& [key, value]: inherited) {
+                it = std::lower_bound(it, merged.begin()+own_end, key, [](const attr_item_v& a, const std::string& k) { return a.first<k; });
+                if (it==merged.begin()+own_end || it->first!=key) {
+                    ++added;
+                }
+            }
+            merged.resize(own_end+added);
+            auto out = merged.size();
+            for (auto inherited_it = inherited.rbegin(); inherited_it!=inherited.rend() && out!=own_end; ++inherited_it) {
+                while (own_end>0 && inherited_it->first<merged[own_end-1].first) {
+                    merged[--out] = std::move(merged[--own_end]);
+                }
+                if (own_end>0 && merged[own_end-1].first==inherited_it->first) {
+                    continue;  // overridden
+                }
+                merged[--out] = attr_item_v{inherited_it->first, inherited_it->second};
+            }
+            return merged;
+        }
+
+        // one open (sub)graph on the explicit stack of resolve_tree
+        struct resolve_frame {
+            const stmt_v* next;  // next statement to resolve
+            const stmt_v* end;
+            external_attrs ext_attrs;
+            dot_graph_resolved resolved;
+            std::size_t path;  // subgraph path in the attr_index, if any
+        };
 
-            for (const auto& stmt: raw_graph.statements) {
+        // resolves the statements [begin, end) as a (sub)graph at the given depth
+        template<typename Checks>
+        dot_graph_resolved resolve_tree(const dot_graph_raw& raw_graph,
+                                        const stmt_v* begin, const stmt_v* end, const std::string& name,
+                                        external_attrs ext_attrs, Checks& checks, const resolve_options& options,
+                                        std::size_t depth, attr_index* index, std::size_t path) {
+            std::vector<resolve_frame> stack;
+            stack.push_back(resolve_frame{ begin, end, ext_attrs,
+                                           dot_graph_resolved{ raw_graph.is_strict,
+                                                               raw_graph.graph_type,  // "graph" or "digraph"
+                                                               name, ext_attrs.graph },
+                                           path });
+            stack.back().resolved.statements.reserve(end-begin);
+            while (true) {
+                auto& top = stack.back();
+                if (top.next==top.end) {  // (sub)graph done; hand it over to its parent
+                    auto done = std::move(top.resolved);
+                    stack.pop_back();
+                    if (options.compute_hashes) {  // children are done already
+                        done.hash = structural_hash(done);
+                    }
+                    if (stack.empty()) {
+                        return done;
+                    }
+                    stack.back().resolved.statements.emplace_back(std::move(done));
+                    continue;
+                }
+                const auto& stmt = *top.next++;
+                auto& resolved = top.resolved;
+                auto& ext = top.ext_attrs;
                 if (std::holds_alternative<attr_item_v>(stmt.val)) {  // we decide that the 'ID'='ID' rule adds a private attr to the current graph/subgraph
                     const auto& v = std::get<attr_item_v>(stmt.val);
                     resolved.graph_attrs.insert_or_assign(v.first, v.second);  // no insertion to ext_attrs
                 } else if (std::holds_alternative<attr_stmt_v>(stmt.val)) {
                     const auto& v = std::get<attr_stmt_v>(stmt.val);
-                    auto& attr_table = [&v, &ext_attrs]() -> auto& {
+                    auto& attr_table = [&v, &ext]() -> auto& {
                         if (v.type=="graph") {
-                            return ext_attrs.graph;  // graph[...] adds public attrs, which will be inherited by subgraphs
+                            return ext.graph;  // graph[...] adds public attrs, which will be inherited by subgraphs
                         } else if (v.type=="node") {
-                            return ext_attrs.node;
+                            return ext.node;
                         } else {
                             assert(v.type=="edge");
-                            return ext_attrs.edge;
+                            return ext.edge;
                         }
                     }();
                     for (const auto& attr_pair: v.attrs) {
@@ -37,94 +235,466 @@ namespace dot_parser {
                 } else if (std::holds_alternative<node_stmt_v>(stmt.val)) {
                     const auto& v = std::get<node_stmt_v>(stmt.val);
                     // check node validity
-                    if (nodes_seen.contains(v.node_name)) {
-                        throw std::runtime_error("redefining node: " + v.node_name);
-                    }
-                    nodes_seen.insert(v.node_name);
+                    checks.node(v);
                     // apply external attrs if not already specified by node attrs
-                    // gather node attrs first
-                    std::map<std::string, std::string> node_attrs {v.attrs.begin(), v.attrs.end()};
-                    // insert from ext_attr if not already present
-                    node_attrs.insert(ext_attrs.node.begin(), ext_attrs.node.end());
-                    // put node attr back
-                    std::vector<attr_item_v> new_node_attrs {node_attrs.begin(), node_attrs.end()};
-                    resolved.statements.emplace_back(node_stmt_v{ .node_name=v.node_name, .attrs=std::move(new_node_attrs) });
+                    resolved.statements.emplace_back(node_stmt_v{ .node_name=v.node_name, .attrs=merge_attrs(v.attrs, ext.node) });
+                    if (index) {
+                        index->add_node(std::get<node_stmt_v>(resolved.statements.back()), top.path);
+                    }
                 } else if (std::holds_alternative<edge_stmt_v>(stmt.val)) {
                     const auto& v = std::get<edge_stmt_v>(stmt.val);
                     // check edge validity
-                    for (const auto& e: v.edges) {
-                        // undefined node(s)
-                        if (!nodes_seen.contains(e.src) || !nodes_seen.contains(e.tgt)) {
-                            throw std::runtime_error("edge " + e.to_string() + " contains undefined node(s)");
-                        }
-                        // conflicting edge op
-                        if (raw_graph.graph_type=="graph" && e.edge_op=="->") {
-                            throw std::runtime_error("directed edge (" + e.to_string() + ") in an undirected graph");
-                        } else if (raw_graph.graph_type=="digraph" && e.edge_op=="--") {
-                            throw std::runtime_error("undirected edge (" + e.to_string() + ") in a directed graph");
-                        }
-                        // multi-edge
-                        if (raw_graph.is_strict) {  // disallow multi-edge
-                            if (edges_seen.contains(e)) {
-                                throw std::runtime_error("duplicate edges for a strict graph: " + e.to_string());
-                            }
-                            edges_seen.insert(e);
-                        }
-                    }
+                    checks.edges(v);
                     // similar to node stmt
-                    std::map<std::string, std::string> edge_attrs {v.attrs.begin(), v.attrs.end()};
-                    edge_attrs.insert(ext_attrs.edge.begin(), ext_attrs.edge.end());
-                    std::vector<attr_item_v> new_edge_attrs { edge_attrs.begin(), edge_attrs.end() };
-                    resolved.statements.emplace_back(edge_stmt_v{ .edges=v.edges, .attrs=std::move(new_edge_attrs) });
+                    resolved.statements.emplace_back(edge_stmt_v{ .edges=v.edges, .attrs=merge_attrs(v.attrs, ext.edge) });
+                    if (index) {
+                        index->add_edges(std::get<edge_stmt_v>(resolved.statements.back()));
+                    }
                 } else {  // a subgraph is encountered
                     assert(std::holds_alternative<std::vector<stmt_v>>(stmt.val));
                     const auto& v = std::get<std::vector<stmt_v>>(stmt.val);
-                    // construct a raw graph first
-                    dot_graph_raw sub_raw_graph { .is_strict=raw_graph.is_strict,
-                                                  .graph_type=raw_graph.graph_type,
-                                                  .name=stmt.name,
-                                                  .statements=v };
-                    // recurse; pass on ext attrs "as is"
-                    resolved.statements.emplace_back(resolve_impl(sub_raw_graph, ext_attrs, nodes_seen, edges_seen));
+                    if (depth+stack.size()>options.max_depth) {
+                        throw std::runtime_error("subgraphs nested deeper than " + std::to_string(options.max_depth) + " levels");
+                    }
+                    // open a new frame; pass on ext attrs "as is"
+                    resolve_frame sub { v.data(), v.data()+v.size(), ext,
+                                        dot_graph_resolved{ raw_graph.is_strict, raw_graph.graph_type, stmt.name, ext.graph },
+                                        index ? index->add_subgraph(top.path, stmt.name) : attr_index::root_path };
+                    sub.resolved.statements.reserve(v.size());
+                    stack.push_back(std::move(sub));  // invalidates top
+                }
+            }
+        }
+
+        dot_graph_resolved resolve_impl(const dot_graph_raw& raw_graph,
+                                        external_attrs ext_attrs,
+                                        node_set& nodes_seen,
+                                        edge_set& edges_seen,
+                                        const resolve_options& options) {
+            sequential_checks checks{raw_graph, nodes_seen, edges_seen};
+            const auto& stmts = raw_graph.statements;
+            return resolve_tree(raw_graph, stmts.data(), stmts.data()+stmts.size(), raw_graph.name,
+                                std::move(ext_attrs), checks, options, 0, options.index, attr_index::root_path);
+        }
+
+        // a top-level subgraph, or a run of top-level statements in between subgraphs
+        struct segment {
+            const stmt_v* begin;
+            const stmt_v* end;
+            bool is_subgraph;
+            external_attrs ext_attrs;  // inherited at begin
+            std::uint64_t position;  // of the first node/edge in the segment
+        };
+
+        // inherited attributes after a top-level attr_stmt; the graph attrs of the (sub)graph itself are the caller's business
+        void apply_attr_stmt(external_attrs& ext, const attr_stmt_v& v) {
+            auto& attr_table = v.type=="graph" ? ext.graph : (v.type=="node" ? ext.node : ext.edge);
+            for (const auto& attr_pair: v.attrs) {
+                attr_table.insert_or_assign(attr_pair.first, attr_pair.second);
+            }
+        }
+
+        // result of the ordered declaration pass of the parallel resolve
+        struct declarations {
+            std::map<std::string, std::string> graph_attrs;  // of the top-level graph
+            std::vector<segment> segments;
+            bool valid = true;  // false if the sequential resolve would throw for anything but duplicate edges
+            // positions count node statements and single edges in declaration order
+            flat_hash_map<std::string_view, std::uint64_t> node_positions;  // first declaration
+        };
+
+        // walks the whole graph in declaration order, checking everything the sequential resolve checks
+        // except for duplicate edges; attributes are only tracked on the top level, to cut it into segments
+        // stops at the first error
+        declarations declare(const dot_graph_raw& raw_graph, const resolve_options& options) {
+            declarations result;
+            result.node_positions.reserve(raw_graph.stats.node_stmts);
+            external_attrs ext;
+            std::uint64_t position = 0;
+            std::vector<std::pair<const stmt_v*, const stmt_v*>> stack;  // (next, end) per open (sub)graph
+            stack.emplace_back(raw_graph.statements.data(), raw_graph.statements.data()+raw_graph.statements.size());
+            while (!stack.empty()) {
+                if (!result.valid) {
+                    return result;
+                }
+                auto& [next, end] = stack.back();
+                if (next==end) {
+                    stack.pop_back();
+                    continue;
+                }
+                const auto& stmt = *next++;
+                bool top_level = stack.size()==1;
+                bool is_subgraph = std::holds_alternative<std::vector<stmt_v>>(stmt.val);
+                if (top_level) {
+                    auto& segments = result.segments;
+                    if (is_subgraph || segments.empty() || segments.back().is_subgraph) {
+                        segments.push_back(segment{&stmt, &stmt+1, is_subgraph, ext, position});
+                    } else {
+                        segments.back().end = &stmt+1;
+                    }
+                }
+                if (std::holds_alternative<attr_item_v>(stmt.val)) {
+                    if (top_level) {
+                        const auto& v = std::get<attr_item_v>(stmt.val);
+                        result.graph_attrs.insert_or_assign(v.first, v.second);
+                    }
+                } else if (std::holds_alternative<attr_stmt_v>(stmt.val)) {
+                    if (top_level) {
+                        const auto& v = std::get<attr_stmt_v>(stmt.val);
+                        apply_attr_stmt(ext, v);
+                        if (v.type=="graph") {
+                            for (const auto& attr_pair: v.attrs) {
+                                result.graph_attrs.insert_or_assign(attr_pair.first, attr_pair.second);
+                            }
+                        }
+                    }
+                } else if (std::holds_alternative<node_stmt_v>(stmt.val)) {
+                    const auto& v = std::get<node_stmt_v>(stmt.val);
+                    if (!result.node_positions.try_emplace(v.node_name, position).second) {
+                        result.valid = false;
+                    }
+                    ++position;
+                } else if (std::holds_alternative<edge_stmt_v>(stmt.val)) {
+                    for (const auto& e: std::get<edge_stmt_v>(stmt.val).edges) {
+                        const auto& nodes = result.node_positions;
+                        if (!nodes.contains(e.src) || !nodes.contains(e.tgt) || edge_op_error(raw_graph, e)) {
+                            result.valid = false;
+                        }
+                        ++position;
+                    }
+                } else {
+                    if (stack.size()>options.max_depth) {
+                        result.valid = false;
+                    }
+                    const auto& v = std::get<std::vector<stmt_v>>(stmt.val);
+                    stack.emplace_back(v.data(), v.data()+v.size());  // invalidates next and end
+                }
+            }
+            return result;
+        }
+
+        // resolved segment, waiting to be stitched into the top-level graph
+        struct resolved_segment {
+            dot_graph_resolved resolved;
+            attr_index index;
+            std::exception_ptr error;
+        };
+
+        dot_graph_resolved resolve_parallel(const dot_graph_raw& raw_graph, const resolve_options& options) {
+            auto decls = declare(raw_graph, options);
+            if (!decls.valid) {  // let the sequential resolve throw the very same error
+                resolve_options sequential = options;
+                sequential.threads = 1;
+                return resolve(raw_graph, sequential);
+            }
+
+            edge_registry strict_edges;
+            std::vector<resolved_segment> results(decls.segments.size());
+            std::atomic<std::size_t> next_segment{0};
+            auto work = [&]() {
+                for (auto i = next_segment++; i < decls.segments.size(); i = next_segment++) {
+                    const auto& seg = decls.segments[i];
+                    auto& out = results[i];
+                    try {
+                        deferred_checks checks{ raw_graph.is_strict ? &strict_edges : nullptr, seg.position };
+                        attr_index* index = options.index ? &out.index : nullptr;
+                        if (seg.is_subgraph) {
+                            const auto& sub = std::get<std::vector<stmt_v>>(seg.begin->val);
+                            auto path = index ? index->add_subgraph(attr_index::root_path, seg.begin->name) : attr_index::root_path;
+                            out.resolved = resolve_tree(raw_graph, sub.data(), sub.data()+sub.size(), seg.begin->name,
+                                                        seg.ext_attrs, checks, options, 1, index, path);
+                        } else {
+                            out.resolved = resolve_tree(raw_graph, seg.begin, seg.end, raw_graph.name,
+                                                        seg.ext_attrs, checks, options, 0, index, attr_index::root_path);
+                        }
+                    } catch (...) {
+                        out.error = std::current_exception();
+                    }
+                }
+            };
+            auto n_threads = std::min<std::size_t>(
+                    options.threads==0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads,
+                    decls.segments.size());
+            {
+                std::vector<std::thread> pool;
+                struct join_all {  // threads already started are joined on every way out of this block
+                    std::vector<std::thread>& threads;
+                    ~join_all() {
+                        for (auto& t: threads) {
+                            t.join();
+                        }
+                    }
+                } joiner{pool};
+                pool.reserve(n_threads);
+                for (std::size_t i = 1; i < n_threads; ++i) {
+                    try {
+                        pool.emplace_back(work);
+                    } catch (const std::system_error&) {  // out of threads: the ones running share the work
+                        break;
+                    }
                 }
+                work();
             }
+
+            // stitch segments together in declaration order
+            dot_graph_resolved resolved{ raw_graph.is_strict, raw_graph.graph_type, raw_graph.name, std::move(decls.graph_attrs) };
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                auto& out = results[i];
+                if (out.error) {
+                    std::rethrow_exception(out.error);
+                }
+                if (decls.segments[i].is_subgraph) {
+                    resolved.statements.emplace_back(std::move(out.resolved));
+                } else {
+                    auto& stmts = out.resolved.statements;
+                    resolved.statements.insert(resolved.statements.end(),
+                                               std::make_move_iterator(stmts.begin()), std::make_move_iterator(stmts.end()));
+                }
+                if (options.index) {
+                    options.index->merge(std::move(out.index));
+                }
+            }
+            if (auto error = strict_edges.first_duplicate()) {
+                throw std::runtime_error(*error);
+            }
+            if (options.compute_hashes) {
+                resolved.hash = structural_hash(resolved);
+            }
+            resolved.stats = raw_graph.stats;
             return resolved;
         }
     }
 
-    dot_graph_resolved resolve(const dot_graph_raw& raw_graph) {
-        std::unordered_set<edge> edges_seen;
-        std::unordered_set<std::string> nodes_seen;
+    dot_graph_resolved resolve(const dot_graph_raw& raw_graph, const resolve_options& options) {
+        if (options.index) {
+            options.index->clear();
+        }
+        if (options.threads!=1) {
+            return detail::resolve_parallel(raw_graph, options);
+        }
+        detail::node_set nodes_seen{raw_graph.stats.node_stmts};
+        detail::edge_set edges_seen{raw_graph.is_strict ? raw_graph.stats.edges : 0};
         detail::external_attrs ext_attrs;
-        return detail::resolve_impl(raw_graph, ext_attrs, nodes_seen, edges_seen);
+        auto resolved = detail::resolve_impl(raw_graph, ext_attrs, nodes_seen, edges_seen, options);
+        resolved.stats = raw_graph.stats;
+        return resolved;
+    }
+
+    namespace detail {
+        // declaration order for subgraph_resolver, walked in document order only as far as lookups have needed so far
+        // resolve checks statements in document order, so nothing after a subgraph's last statement can affect it
+        struct lazy_declarations {
+            struct subgraph_declaration {
+                std::uint64_t position;  // of the subgraph's first node/edge
+                bool complete;  // all of its statements walked
+            };
+            // positions count node statements and single edges, as in declare
+            flat_hash_map<std::string_view, std::uint64_t> node_positions;  // first declaration
+            flat_hash_map<const edge*, std::uint64_t, edge_ref_hash, edge_ref_eq> edge_positions;  // first occurrence, strict graphs only
+            std::unordered_map<const stmt_v*, subgraph_declaration> subgraphs;  // walked into so far
+
+            struct frame {
+                const stmt_v* next;
+                const stmt_v* end;
+                const stmt_v* subgraph;  // statement that opened the frame, nullptr for the top level
+            };
+            const dot_graph_raw& raw_graph;
+            std::vector<frame> stack;
+            std::uint64_t position{};
+
+            explicit lazy_declarations(const dot_graph_raw& raw_graph)
+                : raw_graph{raw_graph},
+                  stack{ frame{raw_graph.statements.data(), raw_graph.statements.data()+raw_graph.statements.size(), nullptr} } {}
+
+            [[nodiscard]] bool complete(const stmt_v* subgraph) const {
+                if (subgraph==nullptr) {
+                    return stack.empty();
+                }
+                auto it = subgraphs.find(subgraph);
+                return it!=subgraphs.end() && it->second.complete;
+            }
+            // walks on until the given subgraph statement (the whole graph for nullptr) has been walked completely
+            void declare_through(const stmt_v* subgraph) {
+                while (!complete(subgraph)) {
+                    auto& [next, end, owner] = stack.back();
+                    if (next==end) {
+                        if (owner) {
+                            subgraphs.at(owner).complete = true;
+                        }
+                        stack.pop_back();
+                        continue;
+                    }
+                    const auto& stmt = *next++;
+                    if (std::holds_alternative<node_stmt_v>(stmt.val)) {
+                        node_positions.try_emplace(std::get<node_stmt_v>(stmt.val).node_name, position);
+                        ++position;
+                    } else if (std::holds_alternative<edge_stmt_v>(stmt.val)) {
+                        for (const auto& e: std::get<edge_stmt_v>(stmt.val).edges) {
+                            if (raw_graph.is_strict) {
+                                edge_positions.try_emplace(&e, position);
+                            }
+                            ++position;
+                        }
+                    } else if (std::holds_alternative<std::vector<stmt_v>>(stmt.val)) {
+                        subgraphs.emplace(&stmt, subgraph_declaration{position, false});
+                        const auto& v = std::get<std::vector<stmt_v>>(stmt.val);
+                        stack.push_back(frame{v.data(), v.data()+v.size(), &stmt});  // invalidates next, end and owner
+                    }
+                }
+            }
+        };
+
+        // node/edge checks of subgraph_resolver, against the declaration order of the graph up to the subgraph's end
+        struct scope_checks {
+            const dot_graph_raw& raw_graph;
+            const lazy_declarations& decls;
+            std::uint64_t position;
+
+            [[nodiscard]] bool declared_before(const std::string& node) const {
+                const auto* declared = decls.node_positions.find(node);
+                return declared!=nullptr && *declared<position;
+            }
+            void node(const node_stmt_v& v) {
+                if (*decls.node_positions.find(v.node_name)!=position) {
+                    throw std::runtime_error("redefining node: " + v.node_name);
+                }
+                ++position;
+            }
+            void edges(const edge_stmt_v& v) {
+                for (const auto& e: v.edges) {
+                    if (!declared_before(e.src) || !declared_before(e.tgt)) {
+                        throw std::runtime_error("edge " + e.to_string() + " contains undefined node(s)");
+                    }
+                    if (auto error = edge_op_error(raw_graph, e)) {
+                        throw std::runtime_error(*error);
+                    }
+                    if (raw_graph.is_strict && *decls.edge_positions.find(&e)!=position) {
+                        throw std::runtime_error("duplicate edges for a strict graph: " + e.to_string());
+                    }
+                    ++position;
+                }
+            }
+        };
+
+        // memoized (sub)graph of subgraph_resolver
+        struct scope {
+            const stmt_v* begin;
+            const stmt_v* end;
+            const stmt_v* subgraph;  // statement of the subgraph, nullptr for the top level
+            external_attrs ext_attrs;  // inherited at begin
+            // first subgraph of each name among the direct statements scanned so far
+            std::unordered_map<std::string, std::unique_ptr<scope>> children;
+            std::size_t scanned{};  // direct statements looked at by child()
+            std::optional<external_attrs> scan_attrs;  // inherited after them
+
+            // scans the direct statements only as far as the requested subgraph; nullptr if there is none
+            scope* child(const std::string& name) {
+                if (auto it = children.find(name); it!=children.end()) {
+                    return it->second.get();
+                }
+                if (!scan_attrs) {
+                    scan_attrs = ext_attrs;
+                }
+                while (begin+scanned!=end) {
+                    const auto* stmt = begin+scanned++;
+                    if (std::holds_alternative<attr_stmt_v>(stmt->val)) {
+                        apply_attr_stmt(*scan_attrs, std::get<attr_stmt_v>(stmt->val));
+                    } else if (std::holds_alternative<std::vector<stmt_v>>(stmt->val)) {
+                        auto [it, inserted] = children.try_emplace(stmt->name);
+                        if (!inserted) {
+                            continue;
+                        }
+                        const auto& v = std::get<std::vector<stmt_v>>(stmt->val);
+                        it->second = std::make_unique<scope>(scope{ .begin=v.data(), .end=v.data()+v.size(),
+                                                                    .subgraph=stmt, .ext_attrs=*scan_attrs });
+                        if (stmt->name==name) {
+                            return it->second.get();
+                        }
+                    }
+                }
+                return nullptr;
+            }
+        };
+
+        struct scope_cache {
+            lazy_declarations decls;
+            scope root;
+        };
+    }
+
+    subgraph_resolver::subgraph_resolver(const dot_graph_raw& raw_graph, resolve_options options)
+        : raw_graph{raw_graph}, options{options},
+          cache{std::make_unique<detail::scope_cache>(detail::scope_cache{
+                detail::lazy_declarations{raw_graph},
+                detail::scope{ .begin=raw_graph.statements.data(), .end=raw_graph.statements.data()+raw_graph.statements.size(),
+                               .subgraph=nullptr, .ext_attrs={} }
+          })} {}
+
+    subgraph_resolver::~subgraph_resolver() = default;
+
+    dot_graph_resolved subgraph_resolver::resolve(const subgraph_path& path) {
+        auto* index = options.index;
+        if (index) {
+            index->clear();
+        }
+        auto index_path = attr_index::root_path;
+        detail::scope* current = &cache->root;
+        for (const auto& name: path) {
+            current = current->child(name);
+            if (current==nullptr) {
+                throw std::runtime_error("no subgraph named '" + name + "'");
+            }
+            if (index) {
+                index_path = index->add_subgraph(index_path, name);
+            }
+        }
+        if (path.size()>options.max_depth) {
+            throw std::runtime_error("subgraphs nested deeper than " + std::to_string(options.max_depth) + " levels");
+        }
+        auto& decls = cache->decls;
+        decls.declare_through(current->subgraph);
+        detail::scope_checks checks{raw_graph, decls, current->subgraph ? decls.subgraphs.at(current->subgraph).position : 0};
+        return detail::resolve_tree(raw_graph, current->begin, current->end, path.empty() ? raw_graph.name : path.back(),
+                                    current->ext_attrs, checks, options, path.size(), index, index_path);
     }
 
     namespace detail {
-        void flatten_impl(const dot_graph_resolved& resolved_graph, std::vector<flat_stmt_type>& statements) {
+        void report_discarded(const dot_graph_resolved& resolved_graph) {
             std::cerr << "graph attributes of (sub)graph";
             if (!resolved_graph.name.empty()) {
                 std::cerr << " with name " << resolved_graph.name;
             }
             std::cerr << " discarded due to flattening\n";
-            for (const auto& stmt: resolved_graph.statements) {
-                if (std::holds_alternative<detail::node_stmt_v>(stmt)) {
-                    const auto& v = std::get<detail::node_stmt_v>(stmt);
-                    statements.emplace_back(v);
-                } else if (std::holds_alternative<detail::edge_stmt_v>(stmt)) {
-                    const auto& v = std::get<detail::edge_stmt_v>(stmt);
-                    statements.emplace_back(v);
-                } else {
-                    assert(std::holds_alternative<dot_graph_resolved>(stmt));
-                    const auto& v = std::get<dot_graph_resolved>(stmt);
-                    flatten_impl(v, statements);
-                }
-            }
         }
     }
 
     dot_graph_flat flatten(const dot_graph_resolved& resolved_graph) {
         dot_graph_flat flat_graph { .is_strict=resolved_graph.is_strict, .graph_type=resolved_graph.graph_type };
-        detail::flatten_impl(resolved_graph, flat_graph.statements);
+        flat_graph.statements.reserve(resolved_graph.stats.node_stmts+resolved_graph.stats.edge_stmts);
+        // (graph, index of next statement); explicit stack in place of recursion
+        std::vector<std::pair<const dot_graph_resolved*, std::size_t>> stack;
+        detail::report_discarded(resolved_graph);
+        stack.emplace_back(&resolved_graph, 0);
+        while (!stack.empty()) {
+            auto& [graph, next] = stack.back();
+            if (next==graph->statements.size()) {
+                stack.pop_back();
+                continue;
+            }
+            const auto& stmt = graph->statements[next++];
+            if (std::holds_alternative<detail::node_stmt_v>(stmt)) {
+                const auto& v = std::get<detail::node_stmt_v>(stmt);
+                flat_graph.statements.emplace_back(v);
+            } else if (std::holds_alternative<detail::edge_stmt_v>(stmt)) {
+                const auto& v = std::get<detail::edge_stmt_v>(stmt);
+                flat_graph.statements.emplace_back(v);
+            } else {
+                assert(std::holds_alternative<dot_graph_resolved>(stmt));
+                const auto& v = std::get<dot_graph_resolved>(stmt);
+                detail::report_discarded(v);
+                stack.emplace_back(&v, 0);  // invalidates graph and next
+            }
+        }
         return flat_graph;
     }
 }
@@ -0,0 +1,68 @@
+#include "snapshot.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace dot_parser {
+    snapshot_holder::snapshot_holder(resolve_options options): options{options} {
+        this->options.index = nullptr;  // an index outside the snapshot would be shared between versions
+    }
+
+    snapshot_holder::~snapshot_holder() {
+        std::lock_guard<std::mutex> lock{pending_mutex};
+        for (auto& f: pending) {
+            f.wait();
+        }
+    }
+
+    snapshot_holder::snapshot_ptr snapshot_holder::get() const {
+        return std::atomic_load(&current);
+    }
+
+    snapshot_holder::snapshot_ptr snapshot_holder::publish(dot_graph_resolved resolved) {
+        return publish(std::move(resolved), ++generations);
+    }
+
+    snapshot_holder::snapshot_ptr snapshot_holder::publish(dot_graph_resolved resolved, std::uint64_t generation) {
+        auto snapshot = std::make_shared<graph_snapshot>();
+        snapshot->flat = flatten(resolved);
+        snapshot->resolved = std::move(resolved);
+        snapshot->generation = generation;
+        auto expected = std::atomic_load(&current);
+        while (true) {
+            if (expected && expected->generation>generation) {
+                return expected;  // a reload requested later got there first
+            }
+            snapshot->version = expected ? expected->version+1 : 1;
+            snapshot_ptr published = snapshot;
+            if (std::atomic_compare_exchange_weak(&current, &expected, published)) {
+                return published;  // the previous snapshot dies with its last reader
+            }
+        }
+    }
+
+    snapshot_holder::snapshot_ptr snapshot_holder::reload(const std::string& input) {
+        auto generation = ++generations;
+        return publish(resolve(parse(input), options), generation);
+    }
+
+    snapshot_holder::snapshot_ptr snapshot_holder::reload_file(const std::string& path) {
+        auto generation = ++generations;
+        return publish(resolve(parse_file(path), options), generation);
+    }
+
+    std::future<snapshot_holder::snapshot_ptr> snapshot_holder::reload_file_async(const std::string& path) {
+        auto generation = ++generations;
+        auto task = std::make_shared<std::packaged_task<snapshot_ptr()>>([this, path, generation] {
+            return publish(resolve(parse_file(path), options), generation);
+        });
+        auto result = task->get_future();
+        std::lock_guard<std::mutex> lock{pending_mutex};
+        // drop reloads that are done already
+        pending.erase(std::remove_if(pending.begin(), pending.end(), [](const std::future<void>& f) {
+            return f.wait_for(std::chrono::seconds{0})==std::future_status::ready;
+        }), pending.end());
+        pending.push_back(std::async(std::launch::async, [task] { (*task)(); }));
+        return result;
+    }
+}
@@ -0,0 +1,90 @@
+#include "test_utils.hpp"
+#include <cstdlib>
+#include <new>
+
+// counts heap allocations while enabled, to keep an eye on the resolver's allocation behaviour
+// replaces the global allocation functions, which is why this has a test binary of its own
+namespace {
+    bool counting = false;
+    std::size_t allocations = 0;
+
+    void* allocate(std::size_t size, std::size_t alignment=alignof(std::max_align_t)) noexcept {
+        if (counting) {
+            ++allocations;
+        }
+        size = size ? size : 1;
+        if (alignment<=alignof(std::max_align_t)) {
+            return std::malloc(size);
+        }
+        return std::aligned_alloc(alignment, (size+alignment-1)/alignment*alignment);
+    }
+    void* allocate_or_throw(std::size_t size, std::size_t alignment=alignof(std::max_align_t)) {
+        if (void* p = allocate(size, alignment)) {
+            return p;
+        }
+        throw std::bad_alloc{};
+    }
+}
+
+void* operator new(std::size_t size) { return allocate_or_throw(size); }
+void* operator new[](std::size_t size) { return allocate_or_throw(size); }
+void* operator new(std::size_t size, std::align_val_t al) { return allocate_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return allocate_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(al)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+template<typename F>
+std::size_t count_allocations(F f) {
+    allocations = 0;
+    counting = true;
+    f();
+    counting = false;
+    return allocations;
+}
+
+TEST(allocations, resolve_and_flatten) {
+    // 100 clusters of 100 nodes, each node but the first linked to two others; names fit in std::string's SSO buffer
+    std::stringstream ss;
+    ss << "strict graph {\n" << "node [shape=box, color=red]\n";
+    std::size_t id = 0;
+    for (std::size_t c = 0; c < 100; ++c) {
+        ss << "subgraph c" << c << " {\n";
+        for (std::size_t i = 0; i < 100; ++i, ++id) {
+            ss << "n" << id << " [weight=1, label=x]\n";
+        }
+        for (std::size_t i = 1; i < 100; ++i) {
+            ss << "n" << id-i << " -- {n" << id-i-1 << " n" << (id-i+7)%id << "} [w=2]\n";
+        }
+        ss << "}\n";
+    }
+    ss << "}";
+    auto raw = dot_parser::parse(ss.str());
+    ASSERT_EQ(raw.stats.node_stmts, 10000);
+    ASSERT_EQ(raw.stats.edge_stmts, 9900);
+    ASSERT_EQ(raw.stats.edges, 19800);
+    ASSERT_EQ(raw.stats.subgraphs, 100);
+
+    // one attr list per node, edge list + attr list per edge statement, a few per subgraph (inherited attribute
+    // tables, statement vector) and a constant for the top level and the resolver's sets
+    dot_parser::dot_graph_resolved resolved;
+    auto resolve_allocations = count_allocations([&]{ resolved = dot_parser::resolve(raw); });
+    ASSERT_LE(resolve_allocations, raw.stats.node_stmts + 2*raw.stats.edge_stmts + 8*raw.stats.subgraphs + 64);
+
+    // copies of the same lists, and the flat statement vector
+    auto flatten_allocations = count_allocations([&]{ dot_parser::flatten(resolved); });
+    ASSERT_LE(flatten_allocations, raw.stats.node_stmts + 2*raw.stats.edge_stmts + 64);
+}
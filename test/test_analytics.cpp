@@ -0,0 +1,94 @@
+#include "test_utils.hpp"
+#include "analytics.hpp"
+
+TEST(analytics, small_graphs) {
+    auto flat = dot_parser::flatten(dot_parser::resolve(dot_parser::parse("digraph {A; B; C; D; E; A->B; B->C; C->A; C->D}")));
+    for (std::size_t threads: {1, 4}) {
+        auto adj = dot_parser::make_adjacency(flat, threads);
+        ASSERT_EQ(adj.vertex_count(), 5);
+        ASSERT_EQ(adj.edge_count, 4);
+        ASSERT_EQ(adj.names[2], "C");
+        ASSERT_EQ(adj.out(2).size(), 2);
+        ASSERT_EQ(adj.in(0).size(), 1);
+
+        ASSERT_EQ(dot_parser::connected_components(adj, threads), (std::vector<dot_parser::vertex_id>{0, 0, 0, 0, 4}));
+        ASSERT_EQ(dot_parser::strongly_connected_components(adj), (std::vector<dot_parser::vertex_id>{1, 1, 1, 0, 2}));
+        ASSERT_FALSE(dot_parser::topological_order(adj).has_value());
+        ASSERT_TRUE(dot_parser::has_cycle(adj));
+        ASSERT_EQ(dot_parser::bfs_distances(adj, 0, threads), (std::vector<dot_parser::vertex_id>{0, 1, 2, 3, dot_parser::no_vertex}));
+        auto degrees = dot_parser::degrees(adj, threads);
+        ASSERT_EQ(degrees.out, (std::vector<std::size_t>{2, 2, 1}));
+        ASSERT_EQ(degrees.in, (std::vector<std::size_t>{1, 4}));
+    }
+
+    auto dag = dot_parser::flatten(dot_parser::resolve(dot_parser::parse("digraph {A; B; C; C->B; B->A}")));
+    ASSERT_EQ(dot_parser::topological_order(dot_parser::make_adjacency(dag)), (std::vector<dot_parser::vertex_id>{2, 1, 0}));
+
+    auto tree = dot_parser::flatten(dot_parser::resolve(dot_parser::parse("graph {A; B; C; A--B; B--C}")));
+    auto adj = dot_parser::make_adjacency(tree);
+    ASSERT_FALSE(dot_parser::has_cycle(adj));
+    ASSERT_ANY_THROW(dot_parser::topological_order(adj));
+    ASSERT_EQ(dot_parser::bfs_distances(adj, 2), (std::vector<dot_parser::vertex_id>{2, 1, 0}));
+}
+
+template<typename G>
+concept adjacency_source = requires(G&& g) { dot_parser::make_adjacency(std::forward<G>(g)); };
+static_assert(adjacency_source<const dot_parser::dot_graph_flat&>);
+static_assert(!adjacency_source<dot_parser::dot_graph_flat>);  // names would point into a temporary
+
+TEST(analytics, threads) {
+    // large enough for several chunks on every parallel path: 0 -> 1..10000 -> 10001..18999, some of them back,
+    // and separate pairs from 19000 on; the last nodes are declared after the edges that use them
+    const std::size_t n = 20000;
+    auto name = [](std::size_t v) { return "n" + std::to_string(v); };
+    for (std::string type: {"digraph", "graph"}) {
+        std::string op = type=="digraph" ? "->" : "--";
+        dot_parser::dot_graph_flat flat{ .graph_type=type };
+        auto add_edge = [&](std::size_t src, std::size_t tgt) {
+            flat.statements.emplace_back(dot_parser::detail::edge_stmt_v{ .edges={dot_parser::edge{name(src), op, name(tgt)}} });
+        };
+        for (std::size_t v = 0; v < n-10; ++v) {
+            flat.statements.emplace_back(dot_parser::detail::node_stmt_v{ .node_name=name(v) });
+        }
+        for (std::size_t v = 1; v <= 10000; ++v) {
+            add_edge(0, v);
+        }
+        for (std::size_t v = 1; v < 9000; ++v) {
+            add_edge(v, v+10000);
+            if (v%7==0) {
+                add_edge(v+10000, v);
+            }
+        }
+        for (std::size_t v = 19000; v < n; v += 2) {
+            add_edge(v, v+1);
+        }
+        for (std::size_t v = n-10; v < n; ++v) {
+            flat.statements.emplace_back(dot_parser::detail::node_stmt_v{ .node_name=name(v) });
+        }
+
+        auto sequential = dot_parser::make_adjacency(flat);
+        auto parallel = dot_parser::make_adjacency(flat, 4);
+        ASSERT_EQ(parallel.vertex_count(), n);
+        ASSERT_EQ(parallel.names, sequential.names);
+        ASSERT_EQ(parallel.out_offsets, sequential.out_offsets);
+        ASSERT_EQ(parallel.out_targets, sequential.out_targets);
+        ASSERT_EQ(parallel.in_offsets, sequential.in_offsets);
+        ASSERT_EQ(parallel.in_sources, sequential.in_sources);
+
+        auto components = dot_parser::connected_components(parallel, 4);
+        ASSERT_EQ(components, dot_parser::connected_components(parallel));
+        ASSERT_EQ(components[18999], 0);
+        ASSERT_EQ(components[19001], 19000);
+
+        auto distances = dot_parser::bfs_distances(parallel, 0, 4);
+        ASSERT_EQ(distances, dot_parser::bfs_distances(parallel, 0));
+        ASSERT_EQ(distances[10000], 1);
+        ASSERT_EQ(distances[18999], 2);
+        ASSERT_EQ(distances[19000], dot_parser::no_vertex);
+
+        auto parallel_degrees = dot_parser::degrees(parallel, 4);
+        auto sequential_degrees = dot_parser::degrees(parallel);
+        ASSERT_EQ(parallel_degrees.out, sequential_degrees.out);
+        ASSERT_EQ(parallel_degrees.in, sequential_degrees.in);
+    }
+}
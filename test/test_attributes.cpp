@@ -0,0 +1,50 @@
+#include "test_utils.hpp"
+#include "attributes.hpp"
+#include <cmath>
+
+TEST(attributes, decoders) {
+    ASSERT_EQ(dot_parser::parse_number(" 2.5"), 2.5);
+    ASSERT_EQ(dot_parser::parse_number("+3"), 3);
+    ASSERT_FALSE(dot_parser::parse_number("3px"));
+    ASSERT_EQ(dot_parser::parse_point("1,2!"), (dot_parser::point{1, 2, true}));
+    ASSERT_FALSE(dot_parser::parse_point("1;2"));
+    ASSERT_EQ(dot_parser::parse_color("#ff800080"), (dot_parser::color{255, 128, 0, 128}));
+    ASSERT_EQ(dot_parser::parse_color("Red"), (dot_parser::color{255, 0, 0}));
+    ASSERT_EQ(dot_parser::parse_color("0.0 1.0 1.0"), (dot_parser::color{255, 0, 0}));
+    ASSERT_FALSE(dot_parser::parse_color("#12345"));
+    ASSERT_EQ(dot_parser::parse_bool("YES"), true);
+    ASSERT_EQ(dot_parser::parse_bool("0"), false);
+    ASSERT_FALSE(dot_parser::parse_bool("maybe"));
+    ASSERT_EQ(std::get<std::string>(dot_parser::decode("rankdir", "LR")), "LR");
+    ASSERT_TRUE(std::holds_alternative<std::monostate>(dot_parser::decode("rankdir", "XY")));
+    ASSERT_EQ(std::get<std::string>(dot_parser::decode("label", "hi")), "hi");
+}
+
+TEST(attributes, typed_attrs) {
+    std::string inp = "digraph {\n"
+                      "    node [width=1.5]\n"
+                      "    A[pos=\"1,2\"]; B[width=x]; C[color=\"#000000\"]\n"
+                      "    edge [weight=2]\n"
+                      "    A->{B C}; B->C[weight=0.5, constraint=false]\n"
+                      "}";
+    auto resolved = dot_parser::resolve(dot_parser::parse(inp));
+    dot_parser::typed_attrs typed{resolved};
+    ASSERT_EQ(typed.node_count(), 3);
+    ASSERT_EQ(typed.edge_count(), 3);
+    auto a = *typed.node_id("A");
+    ASSERT_EQ(std::get<dot_parser::point>(typed.node_attr(a, "pos")), (dot_parser::point{1, 2}));
+    ASSERT_EQ(&typed.node_attr(a, "pos"), &typed.node_attr(a, "pos"));  // cached
+    ASSERT_TRUE(std::holds_alternative<std::monostate>(typed.node_attr(a, "missing")));
+
+    auto widths = typed.node_numbers("width");
+    ASSERT_EQ(widths[0], 1.5);
+    ASSERT_TRUE(std::isnan(widths[1]));  // malformed
+    ASSERT_EQ(widths[2], 1.5);
+    ASSERT_EQ(typed.edge_numbers("weight"), (std::vector<double>{2, 2, 0.5}));
+    ASSERT_EQ(std::get<bool>(typed.edge_attr(2, "constraint")), false);
+
+    auto flat = dot_parser::flatten(resolved);
+    dot_parser::typed_attrs typed_flat{flat};
+    static_assert(!std::is_constructible_v<dot_parser::typed_attrs, dot_parser::dot_graph_flat>);
+    ASSERT_EQ(typed_flat.node_numbers("width", 0), (std::vector<double>{1.5, 0, 1.5}));
+}
@@ -0,0 +1,39 @@
+#include "test_utils.hpp"
+#include "diff.hpp"
+
+TEST(diff, subgraph_hashes) {
+    std::string before = "graph {\n"
+                         "    A; B\n"
+                         "    subgraph stable {C[color=red]; C--A}\n"
+                         "    subgraph touched {D; E[size=1]; D--E}\n"
+                         "    subgraph gone {F}\n"
+                         "    A--B\n"
+                         "}";
+    std::string after = "graph {\n"
+                        "    A; B\n"
+                        "    subgraph stable {C[color=red]; C--A}\n"
+                        "    subgraph touched {D; E[size=2]; G; E--D; G--D}\n"
+                        "    subgraph {H}\n"
+                        "    B--A[color=blue]\n"
+                        "}";
+    auto old_graph = dot_parser::resolve(dot_parser::parse(before), {.compute_hashes=true});
+    auto new_graph = dot_parser::resolve(dot_parser::parse(after), {.compute_hashes=true});
+    ASSERT_EQ(std::get<dot_parser::dot_graph_resolved>(old_graph.statements[2]).hash,
+              std::get<dot_parser::dot_graph_resolved>(new_graph.statements[2]).hash);
+
+    auto d = dot_parser::diff(old_graph, new_graph);
+    ASSERT_EQ(d.changed_nodes, std::vector<std::string>{"E"});
+    ASSERT_EQ(d.added_nodes, std::vector<std::string>{"G"});
+    ASSERT_TRUE(d.removed_nodes.empty());
+    ASSERT_EQ(d.changed_edges.size(), 1);  // A--B got a color; D--E is the same edge as E--D
+    ASSERT_EQ(d.added_edges.size(), 1);
+    ASSERT_TRUE(d.removed_edges.empty());
+    ASSERT_EQ(d.removed_subgraphs, std::vector<dot_parser::subgraph_path>{{"gone"}});
+    ASSERT_EQ(d.added_subgraphs, std::vector<dot_parser::subgraph_path>{{""}});
+
+    auto rehashed = dot_parser::resolve(dot_parser::parse(before));
+    dot_parser::compute_hashes(rehashed);
+    ASSERT_EQ(rehashed.hash, old_graph.hash);
+    ASSERT_TRUE(dot_parser::diff(old_graph, rehashed).empty());
+    ASSERT_ANY_THROW(dot_parser::diff(old_graph, dot_parser::resolve(dot_parser::parse(before))));
+}
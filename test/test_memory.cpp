@@ -0,0 +1,61 @@
+#include "test_utils.hpp"
+#include "memory.hpp"
+
+TEST(memory, usage_and_compact) {
+    auto raw_graph = dot_parser::parse_file("../test_files/test_0.dot");
+    auto resolved = dot_parser::resolve(raw_graph);
+    auto flat = dot_parser::flatten(resolved);
+    for (auto usage: {dot_parser::memory_usage(raw_graph), dot_parser::memory_usage(resolved), dot_parser::memory_usage(flat)}) {
+        ASSERT_GT(usage.attr_lists, 0);
+        ASSERT_GT(usage.edges, 0);
+        ASSERT_GT(usage.containers, 0);
+        ASSERT_EQ(usage.total(), usage.strings+usage.attr_lists+usage.edges+usage.containers);
+    }
+
+    std::stringstream before, after;
+    parse_resolved_impl(before, resolved, 0);
+    resolved.statements.reserve(100);  // some slack to trim
+    auto usage = dot_parser::memory_usage(resolved).total();
+    auto released = dot_parser::compact(resolved);
+    ASSERT_GT(released, 0);
+    ASSERT_EQ(dot_parser::memory_usage(resolved).total(), usage-released);
+    parse_resolved_impl(after, resolved, 0);
+    ASSERT_EQ(before.str(), after.str());
+
+    dot_parser::compact(raw_graph);
+    dot_parser::compact(flat);
+    ASSERT_EQ(flat.statements.capacity(), flat.statements.size());
+}
+
+TEST(memory, pack) {
+    // packing interns the long keys and values every node and edge repeats
+    std::string repeated = "graph {\n";
+    for (std::size_t i = 0; i < 1000; ++i) {
+        repeated += "n" + std::to_string(i) + " [fillcolor=lightgoldenrodyellow, tooltip=shared_tooltip_text_of_all_nodes]\n";
+    }
+    for (std::size_t i = 1; i < 1000; ++i) {
+        repeated += "n" + std::to_string(i-1) + " -- n" + std::to_string(i) + " [penwidth=2.5]\n";
+    }
+    repeated += "}";
+    auto repeated_flat = dot_parser::flatten(dot_parser::resolve(dot_parser::parse(repeated)));
+    auto packed = dot_parser::pack(repeated_flat);
+    ASSERT_EQ(packed.string_count(), 1+1000+4+1+2);  // graph type, names, node keys/values, edge op, edge key/value
+    auto flat_usage = dot_parser::memory_usage(repeated_flat);
+    auto packed_usage = dot_parser::memory_usage(packed);
+    ASSERT_LT(packed_usage.strings*5, flat_usage.strings);
+    ASSERT_LT(packed_usage.total()*4, flat_usage.total());
+
+    auto print_flat = [](const dot_parser::dot_graph_flat& g) {
+        std::stringstream ss;
+        ss << g.is_strict << g.graph_type << '\n';
+        for (const auto& stmt: g.statements) {
+            if (const auto* v = std::get_if<dot_parser::detail::node_stmt_v>(&stmt)) {
+                parse_node_stmt_impl(ss, *v);
+            } else {
+                parse_edge_stmt_impl(ss, std::get<dot_parser::detail::edge_stmt_v>(stmt));
+            }
+        }
+        return ss.str();
+    };
+    ASSERT_EQ(print_flat(packed.unpack()), print_flat(repeated_flat));
+}
@@ -0,0 +1,37 @@
+#include "test_utils.hpp"
+#include "partition.hpp"
+
+TEST(partition, shards) {
+    auto raw_graph = dot_parser::parse("digraph G {subgraph a {A1; A2; A1->A2}; subgraph b {B1; B2; B1->B2}; A1->B1}");
+    auto resolved = dot_parser::resolve(raw_graph);
+    auto parts = dot_parser::partition(resolved, 2);
+    ASSERT_EQ(parts.shard_count(), 2);
+    ASSERT_EQ(parts.loads()[0].nodes, 2);
+    ASSERT_EQ(parts.loads()[0].edges, 2);  // A1->A2 and the loose A1->B1
+    ASSERT_EQ(parts.loads()[1].nodes, 2);
+    ASSERT_EQ(parts.loads()[1].edges, 1);
+    ASSERT_EQ(parts.node_shard("A2"), 0);
+    ASSERT_EQ(parts.node_shard("B2"), 1);
+    ASSERT_EQ(parts.node_id("B1"), 2);
+    ASSERT_EQ(parts.cut_edges().size(), 1);
+    ASSERT_EQ(parts.cut_edges()[0].e->to_string(), "A1 -> B1");
+    ASSERT_EQ(parts.cut_edges()[0].tgt_shard, 1);
+
+    std::stringstream shard_0, shard_1;
+    dot_parser::write_dot(resolved, parts, {&shard_0, &shard_1});
+    // each shard resolves on its own; the cut edge's foreign end is declared in shard 0
+    ASSERT_EQ(dot_parser::flatten(dot_parser::resolve(dot_parser::parse(shard_0.str()))).statements.size(), 5);
+    ASSERT_EQ(dot_parser::flatten(dot_parser::resolve(dot_parser::parse(shard_1.str()))).statements.size(), 3);
+
+    std::stringstream edges_0;
+    dot_parser::write_edge_list(resolved, parts, {&edges_0, nullptr});
+    auto bytes = edges_0.str();
+    ASSERT_EQ(bytes.size(), 2*2*8);
+    ASSERT_EQ(bytes[16], 0);  // A1
+    ASSERT_EQ(bytes[24], 2);  // B1
+
+    auto flat = dot_parser::flatten(resolved);
+    auto flat_parts = dot_parser::partition(flat, 3);
+    ASSERT_EQ(flat_parts.statement_shards().size(), 7);
+    ASSERT_ANY_THROW(dot_parser::partition(resolved, 0));
+}
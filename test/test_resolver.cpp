@@ -100,4 +100,198 @@ TEST(resolver, test_except) {
         ASSERT_NO_THROW(throw_with_msg(inp));
     }
 
-}
\ No newline at end of file
+}
+
+TEST(resolver, attr_merge) {
+    // own attributes in any order, with repeated keys, over node/edge defaults
+    auto resolved = dot_parser::resolve(dot_parser::parse("digraph {\n"
+                                                          "    node [color=blue, shape=box]\n"
+                                                          "    edge [style=dashed]\n"
+                                                          "    A[width=1, color=red]\n"
+                                                          "    B[width=2, width=3, color=green, color=x]\n"
+                                                          "    C[b=1, a=2, b=3]\n"
+                                                          "    A->B [weight=2, style=bold, style=dotted]\n"
+                                                          "}"));
+    using attrs = dot_parser::detail::attr_list_type;
+    ASSERT_EQ(std::get<dot_parser::detail::node_stmt_v>(resolved.statements[0]).attrs,
+              (attrs{{"color", "red"}, {"shape", "box"}, {"width", "1"}}));
+    ASSERT_EQ(std::get<dot_parser::detail::node_stmt_v>(resolved.statements[1]).attrs,
+              (attrs{{"color", "green"}, {"shape", "box"}, {"width", "2"}}));
+    ASSERT_EQ(std::get<dot_parser::detail::node_stmt_v>(resolved.statements[2]).attrs,
+              (attrs{{"a", "2"}, {"b", "1"}, {"color", "blue"}, {"shape", "box"}}));
+    ASSERT_EQ(std::get<dot_parser::detail::edge_stmt_v>(resolved.statements[3]).attrs,
+              (attrs{{"style", "bold"}, {"weight", "2"}}));
+}
+
+TEST(resolver, deep_nesting) {
+    // subgraph { subgraph { ... { A; A--A } ... } }
+    const std::size_t depth = 20000;
+    std::vector<dot_parser::detail::stmt_v> inner;
+    inner.emplace_back(dot_parser::detail::node_stmt_v{ .node_name="A" });
+    inner.emplace_back(dot_parser::detail::edge_stmt_v{ .edges={ dot_parser::edge{"A", "--", "A"} } });
+    for (std::size_t i = 0; i < depth; ++i) {
+        std::vector<dot_parser::detail::stmt_v> outer;
+        outer.emplace_back("sub_" + std::to_string(i), std::move(inner));
+        inner = std::move(outer);
+    }
+    dot_parser::dot_graph_raw raw { .graph_type="graph", .statements=std::move(inner) };
+
+    ASSERT_ANY_THROW(dot_parser::resolve(raw));  // default limit
+    auto resolved = dot_parser::resolve(raw, {.max_depth=depth});
+    auto flat = dot_parser::flatten(resolved);
+    ASSERT_EQ(flat.statements.size(), 2);
+
+    // copies don't recurse either, and the resolved graph stays an aggregate
+    static_assert(std::is_aggregate_v<dot_parser::dot_graph_resolved>);
+    auto raw_copy = raw;
+    auto resolved_copy = resolved;
+    resolved_copy = dot_parser::resolve(raw_copy, {.max_depth=depth});
+    ASSERT_EQ(dot_parser::flatten(resolved_copy).statements.size(), 2);
+
+    // the index keeps one (parent, name) link per subgraph instead of full paths
+    dot_parser::attr_index index;
+    dot_parser::resolve(raw, {.max_depth=depth, .index=&index});
+    auto path = index.subgraph_path("A");
+    ASSERT_EQ(path.size(), depth);
+    ASSERT_EQ(path.front(), "sub_" + std::to_string(depth-1));
+    ASSERT_EQ(path.back(), "sub_0");
+
+    std::string deep_input = "graph {";
+    for (std::size_t i = 0; i < depth; ++i) {
+        deep_input += "subgraph {";
+    }
+    deep_input += "A" + std::string(depth, '}') + "}";
+    ASSERT_ANY_THROW(dot_parser::parse(deep_input));
+}
+
+
+TEST(resolver, attr_index) {
+    std::string inp = "digraph {\n"
+                      "    node [cluster=0]\n"
+                      "    A; B[cluster=7]\n"
+                      "    subgraph outer {\n"
+                      "        node [cluster=7]\n"
+                      "        C\n"
+                      "        subgraph {D[cluster=1]; edge[style=dashed]; A->C; C->D}\n"
+                      "    }\n"
+                      "    B->D[style=dashed]; A->B\n"
+                      "}";
+    dot_parser::attr_index index;
+    auto resolved = dot_parser::resolve(dot_parser::parse(inp), {.index=&index});
+
+    ASSERT_EQ(index.nodes_with("cluster", "7"), (std::vector<std::string>{"B", "C"}));
+    ASSERT_EQ(index.nodes_with("cluster", "0"), std::vector<std::string>{"A"});
+    ASSERT_TRUE(index.nodes_with("cluster", "42").empty());
+    ASSERT_TRUE(index.nodes_with("color", "red").empty());
+
+    const auto& dashed = index.edges_with("style", "dashed");
+    ASSERT_EQ(dashed.size(), 3);
+    ASSERT_EQ(dashed[2].to_string(), "B -> D");
+
+    ASSERT_TRUE(index.subgraph_path("A").empty());
+    ASSERT_EQ(index.subgraph_path("C"), std::vector<std::string>{"outer"});
+    ASSERT_EQ(index.subgraph_path("D"), (std::vector<std::string>{"outer", ""}));
+    ASSERT_ANY_THROW(index.subgraph_path("X"));
+}
+
+TEST(resolver, parallel) {
+    auto raw_graph = dot_parser::parse_file("../test_files/test_0.dot");
+    std::stringstream sequential, parallel;
+    parse_resolved_impl(sequential, dot_parser::resolve(raw_graph), 0);
+    parse_resolved_impl(parallel, dot_parser::resolve(raw_graph, {.threads=4}), 0);
+    ASSERT_EQ(sequential.str(), parallel.str());
+
+    // index and hashes match the sequential ones as well
+    dot_parser::attr_index sequential_index, parallel_index;
+    auto hashed = dot_parser::resolve(raw_graph, {.index=&sequential_index, .compute_hashes=true});
+    auto hashed_parallel = dot_parser::resolve(raw_graph, {.index=&parallel_index, .compute_hashes=true, .threads=4});
+    std::vector<std::pair<const dot_parser::dot_graph_resolved*, const dot_parser::dot_graph_resolved*>> pending {{&hashed, &hashed_parallel}};
+    while (!pending.empty()) {
+        auto [s, p] = pending.back();
+        pending.pop_back();
+        ASSERT_NE(s->hash, 0);
+        ASSERT_EQ(s->hash, p->hash);
+        ASSERT_EQ(s->statements.size(), p->statements.size());
+        for (std::size_t i = 0; i < s->statements.size(); ++i) {
+            if (const auto* sub = std::get_if<dot_parser::dot_graph_resolved>(&s->statements[i])) {
+                pending.emplace_back(sub, &std::get<dot_parser::dot_graph_resolved>(p->statements[i]));
+            }
+        }
+    }
+    for (const auto& stmt: dot_parser::flatten(hashed).statements) {
+        if (const auto* v = std::get_if<dot_parser::detail::node_stmt_v>(&stmt)) {
+            ASSERT_EQ(sequential_index.subgraph_path(v->node_name), parallel_index.subgraph_path(v->node_name));
+            for (const auto& [key, value]: v->attrs) {
+                ASSERT_EQ(sequential_index.nodes_with(key, value), parallel_index.nodes_with(key, value));
+            }
+        } else {
+            for (const auto& [key, value]: std::get<dot_parser::detail::edge_stmt_v>(stmt).attrs) {
+                ASSERT_EQ(sequential_index.edges_with(key, value), parallel_index.edges_with(key, value));
+            }
+        }
+    }
+
+    auto error_of = [](const std::string& input, std::size_t threads) {
+        try {
+            dot_parser::resolve(dot_parser::parse(input), {.threads=threads});
+        } catch (const std::runtime_error& e) {
+            return std::string{e.what()};
+        }
+        return std::string{};
+    };
+    std::vector<std::string> inputs = {
+            "strict graph {A; B; C; subgraph {A--B}; subgraph {B--C; C--B}; subgraph {B--A}}",
+            "strict graph {A; B; subgraph {A--B}; subgraph {C}; B--A}",
+            "digraph {A; subgraph {B; A->B}; subgraph {A}}",
+            "graph {A; subgraph {A--B}; B}"
+    };
+    for (const auto& inp: inputs) {
+        auto expected = error_of(inp, 1);
+        ASSERT_FALSE(expected.empty());
+        ASSERT_EQ(error_of(inp, 4), expected);
+    }
+}
+
+TEST(resolver, subgraph_resolver) {
+    auto raw_graph = dot_parser::parse_file("../test_files/test_0.dot");
+    auto resolved = dot_parser::resolve(raw_graph);
+    dot_parser::subgraph_resolver on_demand{raw_graph};
+
+    std::stringstream expected, actual;
+    const auto& not_g = std::get<dot_parser::dot_graph_resolved>(resolved.statements[4]);
+    parse_resolved_impl(expected, std::get<dot_parser::dot_graph_resolved>(not_g.statements[3]), 0);
+    parse_resolved_impl(actual, on_demand.resolve({"not_g", ""}), 0);
+    ASSERT_EQ(expected.str(), actual.str());
+    ASSERT_EQ(on_demand.resolve({"not_g"}).statements.size(), 4);
+    ASSERT_ANY_THROW(on_demand.resolve({"not_g", "missing"}));
+
+    // errors inside the requested subgraph only
+    auto raw_bad = dot_parser::parse("strict graph {A; B; A--B; subgraph ok {C; C--A}; subgraph bad {B--A}}");
+    dot_parser::subgraph_resolver bad{raw_bad};
+    ASSERT_NO_THROW(bad.resolve({"ok"}));
+    ASSERT_ANY_THROW(bad.resolve({"bad"}));
+    static_assert(!std::is_constructible_v<dot_parser::subgraph_resolver, dot_parser::dot_graph_raw>);
+
+    // declarations are walked only as far as needed; any lookup order gives the subtrees of resolve
+    auto raw_nested = dot_parser::parse("strict digraph {A; subgraph a {B; A->B; subgraph b {C; B->C}; D; C->D}; "
+                                        "subgraph c {E; D->E}; subgraph b {C->B}}");
+    auto full = dot_parser::resolve(raw_nested);
+    auto text = [](const dot_parser::dot_graph_resolved& g) {
+        std::stringstream ss;
+        parse_resolved_impl(ss, g, 0);
+        return ss.str();
+    };
+    auto sub = [](const dot_parser::dot_graph_resolved& g, std::size_t i) -> const auto& {
+        return std::get<dot_parser::dot_graph_resolved>(g.statements[i]);
+    };
+    dot_parser::subgraph_resolver nested{raw_nested};
+    ASSERT_EQ(text(nested.resolve({"a", "b"})), text(sub(sub(full, 1), 2)));
+    ASSERT_EQ(text(nested.resolve({"c"})), text(sub(full, 2)));
+    ASSERT_EQ(text(nested.resolve({"a"})), text(sub(full, 1)));
+    ASSERT_EQ(text(nested.resolve({"a", "b"})), text(sub(sub(full, 1), 2)));
+    ASSERT_EQ(text(nested.resolve({"b"})), text(sub(full, 3)));
+    ASSERT_EQ(text(nested.resolve({})), text(full));
+    dot_parser::subgraph_resolver bad_first{raw_bad};
+    ASSERT_ANY_THROW(bad_first.resolve({"bad"}));
+    ASSERT_NO_THROW(bad_first.resolve({"ok"}));
+}
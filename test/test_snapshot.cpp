@@ -0,0 +1,30 @@
+#include "test_utils.hpp"
+#include "snapshot.hpp"
+
+TEST(snapshot, reload) {
+    dot_parser::snapshot_holder holder;
+    ASSERT_EQ(holder.get(), nullptr);
+    auto first = holder.reload("graph {A; B; A--B}");
+    ASSERT_EQ(first->version, 1);
+    ASSERT_EQ(holder.get(), first);
+    ASSERT_EQ(first->flat.statements.size(), 3);
+
+    ASSERT_ANY_THROW(holder.reload("graph {A--B}"));  // undefined nodes; the old snapshot stays
+    ASSERT_EQ(holder.get(), first);
+
+    auto reader = holder.get();
+    auto second = holder.reload_file_async("../test_files/test_0.dot").get();
+    ASSERT_EQ(second->version, 2);
+    ASSERT_EQ(holder.get(), second);
+    ASSERT_EQ(reader->flat.statements.size(), 3);  // readers keep their snapshot alive
+    ASSERT_EQ(second->flat.statements.size(), 10);
+
+    // overlapping reloads: the one requested last wins, whichever finishes first
+    for (int i = 0; i < 20; ++i) {
+        auto older = holder.reload_file_async("../test_files/test_0.dot");
+        auto newer = holder.reload("graph {A; B; A--B}");
+        ASSERT_LE(older.get()->generation, newer->generation);
+        ASSERT_EQ(holder.get(), newer);
+        ASSERT_EQ(holder.get()->flat.statements.size(), 3);
+    }
+}
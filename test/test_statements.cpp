@@ -1,4 +1,5 @@
 #include "test_utils.hpp"
+#include "static_graph.hpp"
 
 TEST(test_single, node_stmt) {
     compare("vertex", "vertex\n", parse_node_stmt);
@@ -85,4 +86,45 @@ TEST(test_many, dot_graph) {
                         "\t}\n"
                         "}\n";
     compare(inp_2, sol_2, parse_dot_graph);
-}
\ No newline at end of file
+}
+
+constexpr char fsm_dot[] = R"(strict digraph fsm {
+    rankdir=LR
+    node [shape=circle]
+    idle; run [shape=doublecircle]
+    edge [color=gray]  // applies to the edges below
+    idle -> run -> idle [label=go]
+})";
+
+TEST(test_many, static_graph) {
+    constexpr auto machine = DOT_PARSER_STATIC_GRAPH(fsm_dot);
+    static_assert(machine.is_strict && machine.directed && machine.name=="fsm");
+    static_assert(machine.nodes.size()==2 && machine.edges.size()==2);
+    static_assert(machine.node_index("run")==1);
+    static_assert(machine.node_attr(1, "shape")==std::string_view{"doublecircle"});
+    static_assert(machine.edges[1].src==1 && machine.edges[1].tgt==0);
+    static_assert(machine.graph_attr("rankdir")==std::string_view{"LR"});
+    auto copy = DOT_PARSER_STATIC_GRAPH(fsm_dot);  // parsed at compile time all the same
+    ASSERT_EQ(copy.node_index("idle"), 0);
+
+    // same attributes as parse + resolve
+    auto flat = dot_parser::flatten(dot_parser::resolve(dot_parser::parse(fsm_dot)));
+    std::size_t node = 0, edge = 0;
+    for (const auto& stmt: flat.statements) {
+        if (std::holds_alternative<dot_parser::detail::node_stmt_v>(stmt)) {
+            for (const auto& [key, value]: std::get<dot_parser::detail::node_stmt_v>(stmt).attrs) {
+                ASSERT_EQ(machine.node_attr(node, key), value);
+            }
+            ++node;
+        } else {
+            const auto& v = std::get<dot_parser::detail::edge_stmt_v>(stmt);
+            for (std::size_t i = 0; i < v.edges.size(); ++i, ++edge) {
+                for (const auto& [key, value]: v.attrs) {
+                    ASSERT_EQ(machine.edge_attr(edge, key), value);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(node, 2);
+    ASSERT_EQ(edge, 2);
+}
@@ -2,6 +2,7 @@
 #define DOT_PARSER_TEST_UTILS_CPP
 
 #include "test_utils.hpp"
+#include "detail/grammar.hpp"
 #include <lexy/input/string_input.hpp>
 #include <lexy/action/parse.hpp> // lexy::parse
 #include <lexy_ext/report_error.hpp>
@@ -110,7 +111,7 @@ void parse_stmt_impl(std::ostream& os, const std::vector<dot_parser::detail::stm
 void parse_stmt(std::ostream& os, const std::string& inp) {
     auto txt = lexy::string_input(inp.c_str(), inp.size());
     auto res = lexy::parse<dot_parser::parsing::statement_list>(txt, lexy_ext::report_error).value();
-    parse_stmt_impl(os, res, 0);
+    parse_stmt_impl(os, res.statements, 0);
 }
 
 void parse_resolved_impl(std::ostream& os, const dot_parser::dot_graph_resolved& resolved, size_t indent) {